@@ -44,6 +44,9 @@ SOURCES_TG := $(call rwildcard,$(SRCDIR)/current-target/$(CURRENT_TARGET)/,*.s)
 endif
 SOURCES_TG += $(call rwildcard,$(SRCDIR)/current-target/$(CURRENT_TARGET)/,*.c)
 
+# a file in src/<platform>/ replaces the src/common/ one with the same name
+SOURCES := $(filter-out $(addprefix $(SRCDIR)/common/,$(notdir $(SOURCES_PF))),$(SOURCES))
+
 # remove trailing and leading spaces.
 SOURCES := $(strip $(SOURCES))
 SOURCES_PF := $(strip $(SOURCES_PF))
@@ -90,6 +93,8 @@ ifeq ($(CURRENT_TARGET),pmd85)
 else ifeq ($(CURRENT_TARGET),coco)
 -include ./makefiles/compiler-cmoc.mk
 -include ./makefiles/hirestxt-mod-lib.mk
+else ifeq ($(CURRENT_TARGET),linux)
+-include ./makefiles/compiler-gcc.mk
 else
 -include ./makefiles/compiler-cc65.mk
 endif
@@ -1,6 +1,7 @@
 # until there is a fujinet-lib release for pmd85
 # manually copy and unzip the pmd85 library files into _libs/4.7.4-pmd85
-ifneq ($(CURRENT_TARGET),pmd85)
+# linux builds against the sockets shim in src/linux instead
+ifeq ($(filter $(CURRENT_TARGET),pmd85 linux),)
 -include ./makefiles/fujinet-lib.mk
 endif
 
@@ -0,0 +1,17 @@
+CC := gcc
+
+CFLAGS += -I src/common -I src/$(CURRENT_PLATFORM) -I src/current-target/$(CURRENT_TARGET)
+
+CFLAGS += -I $(SRCDIR)
+
+CFLAGS += -I $(SRCDIR)/include
+
+# Same C dialect the 8-bit compilers take, so host builds catch what would break them
+CFLAGS += -std=gnu89 -Wall -Wdeclaration-after-statement -O2 -g
+
+$(OBJDIR)/$(CURRENT_TARGET)/%.o: %.c $(VERSION_FILE) | $(OBJDIR)
+	@$(call MKDIR,$(dir $@))
+	$(CC) -c -MMD -MP $(CFLAGS) -o $@ $<
+
+$(BUILD_DIR)/$(PROGRAM_TGT): $(OBJECTS) | $(BUILD_DIR)
+	$(CC) $(LDFLAGS) -o $@ $^
@@ -0,0 +1,11 @@
+################################################################
+# COMPILE FLAGS
+
+# Native build for profiling and end-to-end tests against a local
+# zoneserver: FujiNet calls go to BSD sockets and conio to ANSI escapes
+# (src/linux). Run it from a terminal: ./build/killzone.linux
+
+################################################################
+# DISK creation
+
+SUFFIX =
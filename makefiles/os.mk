@@ -21,6 +21,7 @@ CURRENT_PLATFORM_cbm610 := c64
 CURRENT_PLATFORM_vic20 := c64
 CURRENT_PLATFORM_pmd85 := pmd85
 CURRENT_PLATFORM_coco := coco
+CURRENT_PLATFORM_linux := linux
 
 CURRENT_PLATFORM = $(CURRENT_PLATFORM_$(CURRENT_TARGET))
 
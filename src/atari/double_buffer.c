@@ -0,0 +1,126 @@
+/**
+ * KillZone Double Buffer - Atari 8-bit
+ *
+ * Replaces the OS GRAPHICS 0 display list with one that loads a screen
+ * address on every play-area row, so flipping pages is 20 address writes
+ * during vertical blank. Page 0 is the OS screen at SAVMSC, page 1 a buffer
+ * here. The four status rows always show the OS screen, where conio writes.
+ */
+
+#include <atari.h>
+#include <string.h>
+#include "double_buffer.h"
+#include "constants.h"
+
+#define SCREEN_ROWS 24
+#define DL_SIZE (3 + DISPLAY_HEIGHT * 3 + 3 + (SCREEN_ROWS - DISPLAY_HEIGHT - 1) + 3)
+#define PAGE_SIZE (DISPLAY_WIDTH * DISPLAY_HEIGHT)
+
+/* Play-area base screen_put_span writes to (screen.s) */
+extern uint8_t *screen_page;
+
+/* ANTIC can't fetch a display list across a 1K boundary or a row across a 4K
+ * one, and the buffers are wherever the linker puts them: both have slack to
+ * move the real start past a boundary. */
+static uint8_t dl_mem[DL_SIZE * 2 - 1];
+static uint8_t page_mem[PAGE_SIZE + DISPLAY_WIDTH - 1];
+
+static uint8_t *dlist;
+static uint8_t *pages[DBUF_PAGES];
+static void *os_dlist;
+static uint8_t hidden = 0;
+static uint8_t active = 0;
+
+static void wait_vblank(void) {
+    uint8_t t = OS.rtclok[2];
+    while (OS.rtclok[2] == t) {
+        /* The OS bumps RTCLOK at the start of vertical blank */
+    }
+}
+
+/* Point every play-area row of the display list at page p */
+static void show_page(uint8_t p) {
+    uint8_t *lms = dlist + 4;
+    uint16_t addr = (uint16_t)pages[p];
+    uint8_t y;
+    
+    for (y = 0; y < DISPLAY_HEIGHT; y++, lms += 3, addr += DISPLAY_WIDTH) {
+        lms[0] = (uint8_t)addr;
+        lms[1] = (uint8_t)(addr >> 8);
+    }
+    hidden = p ^ 1;
+    screen_page = pages[hidden];
+}
+
+void dbuf_init(void) {
+    uint16_t start;
+    uint16_t boundary;
+    uint8_t *p;
+    uint8_t y;
+    
+    if (active) return;
+    os_dlist = OS.sdlst;
+    pages[0] = OS.savmsc;
+    
+    /* Page 1: if a 4K boundary falls inside, move it to the start of a row */
+    start = (uint16_t)page_mem;
+    boundary = (start | 0x0FFF) + 1;
+    if (boundary - start < PAGE_SIZE) {
+        start += (boundary - start) % DISPLAY_WIDTH;
+    }
+    pages[1] = (uint8_t *)start;
+    
+    /* Display list: start it on the next 1K boundary if it would cross one */
+    start = (uint16_t)dl_mem;
+    if ((start & 0x03FF) + DL_SIZE > 0x0400) {
+        start = (start | 0x03FF) + 1;
+    }
+    dlist = p = (uint8_t *)start;
+    
+    *p++ = DL_BLK8;
+    *p++ = DL_BLK8;
+    *p++ = DL_BLK8;
+    for (y = 0; y < DISPLAY_HEIGHT; y++) {
+        *p++ = DL_LMS(DL_CHR40x8x1);
+        p += 2; /* Filled in by show_page */
+    }
+    *p++ = DL_LMS(DL_CHR40x8x1);
+    *p++ = (uint8_t)((uint16_t)(pages[0] + PAGE_SIZE));
+    *p++ = (uint8_t)((uint16_t)(pages[0] + PAGE_SIZE) >> 8);
+    for (y = DISPLAY_HEIGHT + 1; y < SCREEN_ROWS; y++) {
+        *p++ = DL_CHR40x8x1;
+    }
+    *p++ = DL_JVB;
+    *p++ = (uint8_t)start;
+    *p = (uint8_t)(start >> 8);
+    
+    memset(pages[1], 0, PAGE_SIZE);
+    show_page(0);
+    wait_vblank();
+    OS.sdlst = dlist;
+    active = 1;
+}
+
+void dbuf_close(void) {
+    if (!active) return;
+    wait_vblank();
+    OS.sdlst = os_dlist;
+    screen_page = pages[0];
+    active = 0;
+}
+
+void dbuf_reset(void) {
+    if (!active) return;
+    wait_vblank();
+    show_page(0);
+}
+
+uint8_t dbuf_hidden(void) {
+    return hidden;
+}
+
+void dbuf_flip(void) {
+    if (!active) return;
+    wait_vblank();
+    show_page(hidden);
+}
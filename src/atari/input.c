@@ -3,14 +3,72 @@
  */
 
 #include "input.h"
+#include "keyring.h"
 #include <conio.h>
 #include <stdio.h>
 
+/* Characters for the raw keycodes the ring holds (0 = not used here) */
+static const char key_chars[64] = {
+    'l', 'j', ';', 0,   0,   'k', '+', '*',  /* 0x00 */
+    'o', 0,   'p', 'u', 155, 'i', '-', '=',  /* 0x08 */
+    'v', 0,   'c', 0,   0,   'b', 'x', 'z',  /* 0x10 */
+    '4', 0,   '3', '6', 27,  '5', '2', '1',  /* 0x18 */
+    ',', ' ', '.', 'n', 0,   'm', '/', 0,    /* 0x20 */
+    'r', 0,   'e', 'y', 127, 't', 'w', 'q',  /* 0x28 */
+    '9', 0,   '0', '7', 126, '8', '<', '>',  /* 0x30 */
+    'f', 'h', 'd', 0,   0,   'g', 's', 'a'   /* 0x38 */
+};
+
+/**
+ * Keycode to ATASCII: bit 6 is shift, bit 7 control. Control with
+ * - = + * gives the arrows, as the OS editor does.
+ */
+static char key_char(uint8_t code) {
+    char c;
+
+    if (code & 0x80) {
+        switch (code & 0x3F) {
+            case 0x0E: return 28;
+            case 0x0F: return 29;
+            case 0x06: return 30;
+            case 0x07: return 31;
+            default: return 0;
+        }
+    }
+    c = key_chars[code & 0x3F];
+    if ((code & 0x40) && c >= 'a' && c <= 'z') {
+        c -= 'a' - 'A';
+    }
+    return c;
+}
+
+/**
+ * Next key typed, from the ring while it is on. -1 when there is none.
+ */
+static int next_key(void) {
+    uint8_t code;
+
+    if (keyring_on) {
+        code = keyring_get();
+        return code == 0xFF ? -1 : key_char(code);
+    }
+    return kbhit() ? cgetc() : -1;
+}
+
 /**
  * Initialize input system
  */
 void input_init(void) {
-    /* Nothing to initialize for standard conio input yet */
+    keyring_init();
+    keyring_on = 1;
+}
+
+void input_queue_keys(uint8_t on) {
+    keyring_on = on;
+}
+
+void input_close(void) {
+    keyring_done();
 }
 
 /**
@@ -19,67 +77,77 @@ void input_init(void) {
  */
 input_cmd_t input_check(void) {
     int c;
-    
-    if (!kbhit()) {
-        return CMD_NONE;
-    }
-    
-    c = cgetc();
-    
-    switch (c) {
-        case 'w':
-        case 'W':
-        case 'k':  /* vi-style up */
-        case 28:   /* Atari up arrow */
-            return CMD_UP;
-            
-        case 's':
-        case 'S':
-        case 'j':  /* vi-style down */
-        case 29:   /* Atari down arrow */
-            return CMD_DOWN;
-            
-        case 'a':
-        case 'A':
-        case 'h':  /* vi-style left */
-        case 30:   /* Atari left arrow */
-            return CMD_LEFT;
-            
-        case 'd':
-        case 'D':
-        case 'l':  /* vi-style right */
-        case 31:   /* Atari right arrow */
-            return CMD_RIGHT;
-            
-        case 'r':
-        case 'R':
-            return CMD_REFRESH;
-            
-        case 'q':
-        case 'Q':
-            return CMD_QUIT;
-            
-        case 'y':
-        case 'Y':
-            return CMD_YES;
-            
-        case 'n':
-        case 'N':
-            return CMD_NO;
-            
-        case ' ':
-        case 'f':
-        case 'F':
-            return CMD_ATTACK;
-            
-        default:
-            return CMD_NONE;
+
+    /* Keys that mean nothing here are skipped, so a stray one does not end a burst */
+    while ((c = next_key()) >= 0) {
+        switch (c) {
+            case 'w':
+            case 'W':
+            case 'k':  /* vi-style up */
+            case 28:   /* Atari up arrow */
+                return CMD_UP;
+
+            case 's':
+            case 'S':
+            case 'j':  /* vi-style down */
+            case 29:   /* Atari down arrow */
+                return CMD_DOWN;
+
+            case 'a':
+            case 'A':
+            case 'h':  /* vi-style left */
+            case 30:   /* Atari left arrow */
+                return CMD_LEFT;
+
+            case 'd':
+            case 'D':
+            case 'l':  /* vi-style right */
+            case 31:   /* Atari right arrow */
+                return CMD_RIGHT;
+
+            case 'r':
+            case 'R':
+                return CMD_REFRESH;
+
+            case 'q':
+            case 'Q':
+                return CMD_QUIT;
+
+            case 'y':
+            case 'Y':
+                return CMD_YES;
+
+            case 'n':
+            case 'N':
+                return CMD_NO;
+
+            case ' ':
+            case 'f':
+            case 'F':
+                return CMD_ATTACK;
+
+            case 'p':
+            case 'P':
+                return CMD_STATS;
+
+            default:
+                break;
+        }
     }
+    return CMD_NONE;
 }
 
 /**
  * Wait for a specific key press (blocking)
  */
 char input_wait_key(void) {
-    return cgetc();
+    int c;
+
+    if (!keyring_on) {
+        return cgetc();
+    }
+    while ((c = next_key()) <= 0) {
+        /* Spin until the VBI queues a key we know */
+    }
+    return (char)c;
 }
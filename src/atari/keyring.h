@@ -0,0 +1,22 @@
+/**
+ * KillZone Keyboard Ring - Atari 8-bit
+ *
+ * The OS holds only the last keycode (CH), so keys typed while a frame is
+ * busy overwrite each other. keyring_init hooks the immediate VBI to move
+ * each keycode into a small ring as it arrives; the input module drains it.
+ */
+
+#ifndef KILLZONE_KEYRING_H
+#define KILLZONE_KEYRING_H
+
+#include <stdint.h>
+
+/* Collect keys while set. Clear it before reading a line through the OS,
+ * which needs CH for itself. */
+extern volatile uint8_t keyring_on;
+
+void keyring_init(void);     /* Hook VVBLKI (collection starts off) */
+void keyring_done(void);     /* Stop collecting and restore the old vector */
+uint8_t keyring_get(void);   /* Oldest raw keycode, 0xFF when empty */
+
+#endif /* KILLZONE_KEYRING_H */
@@ -0,0 +1,98 @@
+        .export         _keyring_init
+        .export         _keyring_done
+        .export         _keyring_get
+        .export         _keyring_on
+
+        .include        "atari.inc"
+
+; The OS keyboard interrupt leaves one keycode in CH, and the next key
+; overwrites it if nobody has read it yet. While keyring_on is set, our
+; immediate VBI moves CH into a 16-byte ring every frame. It runs even
+; while SIO holds CRITIC, so keys typed during a blocking network call are
+; kept. When the ring is full the key stays in CH until the next frame.
+
+KEYRING_SIZE = 16               ; a power of two
+
+        .bss
+_keyring_on:    .res    1
+ring:           .res    KEYRING_SIZE
+head:           .res    1       ; written by the VBI
+tail:           .res    1       ; written by keyring_get
+hooked:         .res    1
+
+        .data
+; Patched with the old VVBLKI: a JMP (ind) through a vector that straddled
+; a page would jump to the wrong place
+chain:  jmp     $FFFF
+
+        .code
+
+; void keyring_init(void)
+_keyring_init:
+        lda     #0
+        sta     head
+        sta     tail
+        lda     VVBLKI
+        sta     chain+1
+        lda     VVBLKI+1
+        sta     chain+2
+        lda     #1
+        sta     hooked
+        ldy     #<handler
+        ldx     #>handler
+        lda     #6              ; immediate VBI
+        jmp     SETVBV
+
+; void keyring_done(void)
+_keyring_done:
+        lda     #0
+        sta     _keyring_on
+        lda     hooked
+        beq     done            ; never hooked
+        lda     #0
+        sta     hooked
+        ldy     chain+1
+        ldx     chain+2
+        lda     #6
+        jmp     SETVBV
+done:   rts
+
+; uint8_t keyring_get(void) - oldest keycode, $FF when the ring is empty
+_keyring_get:
+        ldy     tail
+        cpy     head
+        beq     empty
+        lda     ring,y
+        tax
+        iny
+        tya
+        and     #KEYRING_SIZE-1
+        sta     tail
+        txa
+        ldx     #0
+        rts
+empty:  lda     #$FF
+        ldx     #0
+        rts
+
+handler:
+        lda     _keyring_on
+        beq     out
+        lda     CH
+        cmp     #$FF
+        beq     out             ; no key
+        ldx     head
+        inx
+        txa
+        and     #KEYRING_SIZE-1
+        cmp     tail
+        beq     out             ; full: leave it in CH
+        pha                     ; the new head
+        ldx     head
+        lda     CH
+        sta     ring,x
+        pla
+        sta     head
+        lda     #$FF
+        sta     CH
+out:    jmp     chain
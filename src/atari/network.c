@@ -12,23 +12,145 @@
 #include "fujinet-network.h"
 #include "json_helpers.h"
 #include "constants.h"
+#include "timer.h"
+#include "proceed.h"
 #include <conio.h>
 
 /* Toggle for TCP mode - in production this might be a runtime switch or compile-time */
 /* For this step, let's try to prioritize TCP if available, or just have dedicated functions */
 #define USE_TCP 1
 
+/* The HTTP/JSON path is disabled (see kz_network_health_check); its buffers
+ * are only compiled in with it */
+#define USE_HTTP 0
+
 static network_status_t current_status = NET_DISCONNECTED;
+#if USE_HTTP
 static char device_spec[DEVICE_SPEC_SIZE];
 static char path_buf[256];
 static char body_buf[256];
 static char value_buf[256]; /* Buffer for JSON values */
 static char query_buf[64];  /* Buffer for JSON keys/paths */
+#endif
 
 /* TCP connection handle */
 static char tcp_device_spec[64];
 static uint8_t tcp_connected = 0;
 
+/* Protocol version from the 0x05 hello or 0x08 connect: 1 = 8-bit coords, 2 = 16-bit LE coords,
+ * 3 = 16-bit coords with bit-packed 0x07 state, 4 = capability join (0x06),
+ * 5 = single round-trip connect (0x08), 6 = ping/pong (0x0A),
+ * 7 = sequenced move and ack (0x0B), 8 = batched moves (0x0C) */
+#define PROTOCOL_VERSION 8
+static uint8_t protocol_version = 1;
+
+/* Capability bits for the 0x06 join; the server answers with the subset it grants */
+#define CAP_WIDE_COORDS 0x01 /* 16-bit LE coordinates */
+#define CAP_PACKED      0x02 /* Bit-packed 0x07 state */
+#define CAP_DELTA       0x04 /* Runs against the previous packed reply */
+#define CAP_NUMERIC_IDS 0x10 /* State records carry a 16-bit entity id */
+#define CAP_FRAMED      0x20 /* Every reply has [LenLo] [LenHi] after its type */
+#define CAP_RESUME      0x40 /* 0x08 replies carry a token for 0x09 resume */
+#define CAP_UDP         0x80 /* 0x08 replies carry the UDP snapshot port */
+#define CLIENT_CAPS (CAP_WIDE_COORDS | CAP_PACKED | CAP_DELTA | CAP_NUMERIC_IDS | CAP_FRAMED | CAP_RESUME | CAP_UDP)
+static uint8_t codec_caps = 0;
+#define COORD_SIZE ((codec_caps & CAP_WIDE_COORDS) ? 2 : 1)
+#define ID_SIZE ((codec_caps & CAP_NUMERIC_IDS) ? 2 : 0)
+
+/* Token from the last 0x08 reply, for resuming after the link drops */
+static uint8_t resume_token[16];
+static uint8_t resume_token_len = 0;
+
+/* Ping/pong (protocol 6): smoothed RTT and the server tick at the last pong */
+#define PING_INTERVAL_POLLS 50
+static uint8_t ping_countdown = 0;
+static uint16_t srtt8 = 0;        /* Smoothed RTT in jiffies, times 8 */
+static uint16_t pong_ticks = 0;
+static uint16_t pong_at = 0;      /* Local time the server sampled pong_ticks */
+static uint8_t server_tick_hz = 0;
+static uint16_t ping_stamp = 0;   /* Clock stamp of the ping awaiting its pong */
+
+/* Move prediction (protocol 7, FRAMED): a move is applied locally at once and
+ * sent as 0x0B [Seq] [Dir]; its reply, tagged with the same Seq, is read later */
+#define PREDICT_MAX 8              /* Unanswered moves in flight (a power of two) */
+#define USE_PREDICTION (protocol_version >= 7 && (codec_caps & CAP_FRAMED))
+static uint8_t move_seq = 0;       /* Seq of the newest move sent */
+static uint8_t pred_pending = 0;   /* Moves sent but not answered yet */
+static char pred_dir[PREDICT_MAX]; /* Direction of each, indexed by Seq */
+
+/* Batched moves (protocol 8): the moves predicted during a frame are held
+ * here and written together as 0x0C [Seq] [Count] [Dir...] by
+ * kz_network_flush_moves, and the server answers the lot with one 0x0B */
+#define USE_BATCH (protocol_version >= 8 && USE_PREDICTION)
+static uint8_t move_batch[3 + PREDICT_MAX];
+static uint8_t batch_count = 0;
+
+/* Non-blocking exchange (same links as prediction): requests are written and
+ * left; kz_network_pump assembles replies in state_buf a network_read_nb at
+ * a time and applies each by type, so a frame never waits for the server.
+ * One state request is kept in flight and the next goes out as soon as its
+ * reply has been applied. */
+#define USE_NONBLOCKING USE_PREDICTION
+#define PUMP_MAX_FRAMES 4          /* Replies applied per pump */
+#define PROCEED_CHECK_FRAMES 30    /* Read anyway after this many quiet frames */
+static uint16_t rx_have = 0;       /* Bytes of the current reply in state_buf */
+static uint16_t rx_body = 0;       /* Body bytes of it kept in state_buf */
+static uint16_t rx_skip = 0;       /* Body bytes that did not fit, still to discard */
+static uint8_t state_inflight = 0; /* A 0x03 has been sent and not answered */
+static uint8_t tcp_streaming = 0;  /* TCP is the state source: keep requesting */
+
+/* The pump only reads once the FujiNet has raised PROCEED (proceed.h), or
+ * while a burst it stopped reading may still be waiting. Every
+ * PROCEED_CHECK_FRAMES quiet frames it reads anyway; if that finds data the
+ * interrupt never announced, PROCEED is taken not to work here and the pump
+ * reads every frame. */
+static uint8_t proceed_ok = 1;
+static uint8_t rx_more = 0;        /* The last pump stopped with replies left unread */
+static uint8_t quiet_frames = 0;
+
+/* Viewport last declared to the server, so an unchanged one is not resent */
+static uint8_t declared_view_w = 0;
+static uint8_t declared_view_h = 0;
+
+/* UDP snapshot channel: state arrives as 0x11 [SeqLo] [SeqHi] [0x03 or 0x07 state packet].
+ * Datagrams can be lost or reordered, so anything not newer than the last
+ * applied sequence is dropped. Joins and moves stay on TCP. Only used when
+ * the server grants CAP_UDP, which it does while its UDP channel listens;
+ * otherwise state comes straight over TCP. */
+#define USE_UDP (codec_caps & CAP_UDP)
+#define UDP_KEEPALIVE_POLLS 100 /* Resubscribe every this many state polls */
+#define UDP_FALLBACK_POLLS 20   /* Poll over TCP after this many polls without a datagram */
+#define UDP_MAX_DRAIN 8         /* Datagrams read per poll */
+static char udp_device_spec[64];
+static uint16_t udp_port = 0;   /* From the 0x08 reply */
+static uint8_t udp_open = 0;
+static uint8_t udp_have_seq = 0;
+static uint16_t udp_last_seq = 0;
+static uint8_t udp_idle_polls = 0;
+static uint8_t udp_keepalive = 0;
+static char udp_msg[40];
+
+/* Whole state packets: UDP datagrams and packed TCP replies */
+static uint8_t state_buf[512];
+
+/* Packed state (protocol 3): 0x07 [LenLo] [LenHi] [Count varint] [TicksLow] [TicksHigh]
+ * [MsgLen] [Msg...] [XBits] [YBits] ([IdBits] with NUMERIC_IDS) then an MSB-first
+ * bitstream of records:
+ *   0 [Type:2] [Id:IdBits] [X:XBits] [Y:YBits]   literal
+ *   1 [Run-1:4]                                  next Run records unchanged since the last TCP packet
+ * Only TCP replies use runs, so only they update packed_prev. */
+#define PACKED_RUN_BITS 4
+#define PACKED_PREV_MAX (MAX_OTHER_PLAYERS + 1) /* The others and 'M' */
+static const char packed_types[4] = { 'M', 'P', 'H', 'E' };
+static entity_t packed_prev[PACKED_PREV_MAX]; /* kind holds the packed type */
+static uint16_t packed_prev_ticks = 0; /* Identify the stored packet when resuming */
+static uint16_t packed_prev_count = 0;
+
+static const uint8_t *bit_src;
+static const uint8_t *bit_end;
+static uint8_t bit_mask;
+static uint8_t bit_eof;
+
 /* --- TCP Helper Functions --- */
 
 static uint8_t tcp_connect(void) {
@@ -42,6 +164,13 @@ static uint8_t tcp_connect(void) {
         return 0;
     }
     tcp_connected = 1;
+    ping_countdown = 0; /* Measure the new link straight away */
+    pred_pending = 0;   /* Moves in flight on the old link are lost or already applied */
+    batch_count = 0;
+    rx_have = 0;
+    rx_body = 0;
+    rx_skip = 0;
+    state_inflight = 0;
     return 1;
 }
 
@@ -52,23 +181,510 @@ static void tcp_disconnect(void) {
     }
 }
 
+/* Decode a coordinate in the negotiated width */
+static uint16_t read_coord(const uint8_t *p) {
+    if (codec_caps & CAP_WIDE_COORDS) {
+        return p[0] | ((uint16_t)p[1] << 8);
+    }
+    return p[0];
+}
+
+/* Negotiate the protocol version and learn the world size.
+ * Servers without 0x05 never answer, so we stay on version 1. */
+static void tcp_hello(void) {
+    uint8_t buf[6];
+    int len;
+    
+    protocol_version = 1;
+    codec_caps = 0;
+    
+    /* Packet: 0x05 [Version] */
+    buf[0] = 0x05;
+    buf[1] = PROTOCOL_VERSION;
+    if (network_write(tcp_device_spec, buf, 2) != FN_ERR_OK) return;
+    
+    /* Resp: 0x05 [Version] [WidthLo] [WidthHi] [HeightLo] [HeightHi] */
+    len = network_read(tcp_device_spec, buf, 6);
+    if (len < 6 || buf[0] != 0x05) return;
+    
+    protocol_version = buf[1];
+    /* What each version implies; a 0x06 join may narrow it */
+    if (protocol_version >= 3) codec_caps = CAP_WIDE_COORDS | CAP_PACKED | CAP_DELTA;
+    else if (protocol_version == 2) codec_caps = CAP_WIDE_COORDS;
+    state_set_world_dimensions(buf[2] | ((uint16_t)buf[3] << 8), buf[4] | ((uint16_t)buf[5] << 8));
+}
+
+/* Read one length-prefixed reply into state_buf: [Type] [LenLo] [LenHi] [Body...].
+ * Two network_read calls however many entities it holds. A body too big for
+ * the buffer is truncated (the decoders stop at the end) and the rest drained.
+ * Returns the body length stored, or -1 on error. */
+static int tcp_read_frame(void) {
+    uint8_t skip[16];
+    uint16_t bodyLen;
+    uint16_t want;
+    int len;
+    
+    len = network_read(tcp_device_spec, state_buf, 3);
+    if (len < 3) return -1;
+    bodyLen = state_buf[1] | ((uint16_t)state_buf[2] << 8);
+    
+    want = bodyLen > sizeof(state_buf) - 3 ? sizeof(state_buf) - 3 : bodyLen;
+    if (want > 0) {
+        len = network_read(tcp_device_spec, state_buf + 3, want);
+        if (len < (int)want) return -1;
+    }
+    
+    /* Keep the stream in sync */
+    for (bodyLen -= want; bodyLen > 0; bodyLen -= len) {
+        len = network_read(tcp_device_spec, skip, bodyLen > sizeof(skip) ? sizeof(skip) : bodyLen);
+        if (len <= 0) return -1;
+    }
+    return want;
+}
+
+/* tcp_read_frame without waiting: take in whatever part of the current reply
+ * has arrived. Returns the body length once the whole reply is in state_buf,
+ * -1 while it is still incomplete, or -2 if the link failed. */
+static int tcp_poll_frame(void) {
+    uint8_t skip[16];
+    uint16_t bodyLen;
+    int16_t len;
+    
+    /* rx_body and rx_skip are set once, from the header: rx_skip counts down
+     * while the tail is discarded, so the kept length is never derived from it */
+    if (rx_have < 3) {
+        len = network_read_nb(tcp_device_spec, state_buf + rx_have, 3 - rx_have);
+        if (len < 0) return -2;
+        rx_have += len;
+        if (rx_have < 3) return -1;
+        bodyLen = state_buf[1] | ((uint16_t)state_buf[2] << 8);
+        rx_body = bodyLen > sizeof(state_buf) - 3 ? sizeof(state_buf) - 3 : bodyLen;
+        rx_skip = bodyLen - rx_body;
+    }
+    
+    if (rx_have < 3 + rx_body) {
+        len = network_read_nb(tcp_device_spec, state_buf + rx_have, 3 + rx_body - rx_have);
+        if (len < 0) return -2;
+        rx_have += len;
+        if (rx_have < 3 + rx_body) return -1;
+    }
+    while (rx_skip > 0) {
+        len = network_read_nb(tcp_device_spec, skip, rx_skip > sizeof(skip) ? sizeof(skip) : rx_skip);
+        if (len < 0) return -2;
+        if (len == 0) return -1;
+        rx_skip -= len;
+    }
+    
+    rx_have = 0;
+    return rx_body;
+}
+
+/* Where a move takes us if nothing gets in the way: one step, kept inside the
+ * world. Walking into an entity starts a fight, which never moves us. */
+static void predict_step(char dir, uint16_t *x, uint16_t *y) {
+    uint16_t nx = *x;
+    uint16_t ny = *y;
+    
+    switch (dir) {
+        case 'u': if (ny > 0) ny--; break;
+        case 'd': if (ny + 1 < state_get_world_height()) ny++; break;
+        case 'l': if (nx > 0) nx--; break;
+        case 'r': if (nx + 1 < state_get_world_width()) nx++; break;
+        default: return;
+    }
+    if (state_other_at(nx, ny)) return;
+    *x = nx;
+    *y = ny;
+}
+
+/* Apply a move reply held in state_buf by tcp_read_frame:
+ * 0x0B [LenLo] [LenHi] [Seq] [X] [Y] [Health] [Collision] [MsgLen] [Msg...]
+ * The server's position replaces ours and the moves it has not answered yet are
+ * replayed on top, so a blocked move or a fight rolls the prediction back
+ * without losing the keypresses after it. */
+static void apply_move_ack(int len) {
+    const uint8_t *m = state_buf + 3;
+    player_state_t *local = (player_state_t *)state_get_local_player();
+    uint8_t answered;
+    uint8_t seq;
+    uint8_t msgLen;
+    uint16_t x;
+    uint16_t y;
+    
+    if (len < 4 + COORD_SIZE * 2) return;
+    answered = (uint8_t)(m[0] - (uint8_t)(move_seq - pred_pending));
+    if (answered == 0 || answered > pred_pending) return; /* Not one of ours */
+    pred_pending -= answered;
+    if (!local) return;
+    
+    x = read_coord(m + 1);
+    y = read_coord(m + 1 + COORD_SIZE);
+    for (seq = move_seq - pred_pending + 1; seq != (uint8_t)(move_seq + 1); seq++) {
+        predict_step(pred_dir[seq & (PREDICT_MAX - 1)], &x, &y);
+    }
+    local->x = x;
+    local->y = y;
+    local->health = m[1 + COORD_SIZE * 2];
+    
+    msgLen = m[3 + COORD_SIZE * 2];
+    if (msgLen > 0 && msgLen < 40 && 4 + COORD_SIZE * 2 + msgLen <= len) {
+        memcpy(udp_msg, m + 4 + COORD_SIZE * 2, msgLen);
+        udp_msg[msgLen] = '\0';
+        state_set_combat_message(udp_msg);
+    }
+}
+
+/* Read the next reply that is not a move ack, applying the acks ahead of it.
+ * Returns the body length as tcp_read_frame does. */
+static int tcp_read_reply(void) {
+    int len;
+    
+    while ((len = tcp_read_frame()) >= 0 && state_buf[0] == 0x0B) {
+        apply_move_ack(len);
+    }
+    return len;
+}
+
+/* Take in the move acks that have already arrived, without waiting for more */
+static void tcp_drain_acks(void) {
+    uint16_t waiting;
+    uint8_t connected;
+    uint8_t err;
+    int len;
+    
+    while (pred_pending > 0 &&
+           network_status(tcp_device_spec, &waiting, &connected, &err) == FN_ERR_OK && waiting >= 3) {
+        len = tcp_read_frame();
+        if (len < 0) return;
+        if (state_buf[0] == 0x0B) apply_move_ack(len);
+    }
+}
+
+/* Ping: 0x0A [StampLo] [StampHi] [RttLo] [RttHi]
+ * -> 0x0A [StampLo] [StampHi] [TicksLo] [TicksHi] [TickHz] [TimeMs x4]
+ * Our clock goes out as the stamp and comes back, so one reply gives one RTT
+ * sample. Rtt reports the smoothed value (ms) so the server can export it. */
+static void apply_pong(const uint8_t *m);
+
+static void tcp_ping(void) {
+    uint8_t buf[5];
+    uint16_t rtt = state_get_rtt();
+    int len;
+    
+    ping_stamp = timer_now();
+    buf[0] = 0x0A;
+    buf[1] = (uint8_t)ping_stamp;
+    buf[2] = (uint8_t)(ping_stamp >> 8);
+    buf[3] = (uint8_t)rtt;
+    buf[4] = (uint8_t)(rtt >> 8);
+    if (network_write(tcp_device_spec, buf, 5) != FN_ERR_OK) return;
+    if (USE_NONBLOCKING) return; /* The pong is applied by kz_network_pump */
+    
+    if (codec_caps & CAP_FRAMED) {
+        len = tcp_read_reply();
+        if (len < 9 || state_buf[0] != 0x0A) return;
+        apply_pong(state_buf + 2);
+    } else {
+        len = network_read(tcp_device_spec, state_buf, 10);
+        if (len < 10 || state_buf[0] != 0x0A) return;
+        apply_pong(state_buf);
+    }
+}
+
+/* Take one RTT sample from a pong laid out as an unframed reply: m[0] is the type */
+static void apply_pong(const uint8_t *m) {
+    uint16_t sample;
+    uint16_t rtt;
+    
+    if ((m[1] | ((uint16_t)m[2] << 8)) != ping_stamp) return;
+    
+    sample = timer_now() - ping_stamp;
+    /* Smooth with gain 1/8 (as TCP does), keeping three fraction bits */
+    if (srtt8 == 0) {
+        srtt8 = (sample << 3) | 1;
+    } else {
+        srtt8 = srtt8 + sample - (srtt8 >> 3);
+    }
+    rtt = (uint16_t)(((uint32_t)srtt8 * 125) / TIMER_HZ);
+    state_set_rtt(rtt ? rtt : 1);
+    
+    /* The server read its tick about half a round trip ago */
+    pong_ticks = m[3] | ((uint16_t)m[4] << 8);
+    server_tick_hz = m[5];
+    pong_at = ping_stamp + (sample >> 1);
+}
+
+uint16_t kz_network_server_tick(void) {
+    uint16_t elapsed;
+    
+    if (server_tick_hz == 0 || srtt8 == 0) {
+        /* Ticks only advance as state is polled: the last state is current */
+        return state_get_world_ticks();
+    }
+    elapsed = timer_now() - pong_at;
+    return pong_ticks + (uint16_t)(((uint32_t)elapsed * server_tick_hz) / TIMER_HZ);
+}
+
+/* --- UDP Helper Functions --- */
+
+/* Register for pushed snapshots: 0x10 [IdLen] [PlayerId]. Also the keepalive. */
+static void udp_subscribe(void) {
+    static uint8_t buf[64];
+    const player_state_t *local = state_get_local_player();
+    uint8_t idLen;
+    
+    if (!local) return;
+    if (!udp_open) {
+        snprintf(udp_device_spec, sizeof(udp_device_spec), "N:UDP://%s:%u", SERVER_HOST, udp_port);
+        if (network_open(udp_device_spec, 0x0C, 0) != FN_ERR_OK) return;
+        udp_open = 1;
+        udp_have_seq = 0;
+        udp_idle_polls = 0;
+    }
+    
+    idLen = (uint8_t)strlen(local->id);
+    if (idLen > sizeof(buf) - 2) idLen = sizeof(buf) - 2;
+    buf[0] = 0x10;
+    buf[1] = idLen;
+    memcpy(&buf[2], local->id, idLen);
+    network_write(udp_device_spec, buf, 2 + idLen);
+}
+
+static void udp_close(void) {
+    if (udp_open) {
+        network_close(udp_device_spec);
+        udp_open = 0;
+    }
+}
+
+/* After a join or resume: subscribe if the server offered UDP, else stay on TCP */
+static void udp_follow_caps(void) {
+    if (USE_UDP) {
+        udp_subscribe();
+    } else {
+        udp_close();
+    }
+}
+
+/* Store one decoded entity; 'M' updates the local player instead.
+ * eid is 0 when ids were not negotiated. Returns the new count of other entities. */
+static uint8_t store_entity(uint8_t count, char typeChar, uint16_t eid, uint16_t x, uint16_t y) {
+    player_state_t *p;
+    entity_t *e;
+    
+    if (typeChar == 'M') {
+        /* A snapshot may predate the moves in flight: keep the prediction until they are answered */
+        p = (player_state_t *)state_get_local_player();
+        if (p && pred_pending == 0) {
+            p->x = x;
+            p->y = y;
+        }
+        return count;
+    }
+    if (count >= MAX_OTHER_PLAYERS) return count;
+    
+    e = state_other_players_table() + count;
+    e->eid = eid;
+    e->x = x;
+    e->y = y;
+    e->kind = typeChar == 'P' ? ENTITY_PLAYER : typeChar == 'H' ? ENTITY_HUNTER : 0;
+    return count + 1;
+}
+
+/* Apply a complete 0x03 state packet held in memory */
+static void apply_state_buffer(const uint8_t *p, uint16_t len) {
+    uint8_t count = p[1];
+    uint8_t msgLen = p[4];
+    uint8_t rec_len = 1 + ID_SIZE + COORD_SIZE * 2;
+    uint8_t actual_count = 0;
+    uint8_t i;
+    uint16_t off;
+    uint16_t eid;
+    
+    state_set_world_ticks(p[2] | ((uint16_t)p[3] << 8));
+    if (msgLen > 0 && msgLen < 40 && 5 + msgLen <= len) {
+        memcpy(udp_msg, p + 5, msgLen);
+        udp_msg[msgLen] = '\0';
+        state_set_combat_message(udp_msg);
+    }
+    
+    off = 5 + msgLen;
+    for (i = 0; i < count && off + rec_len <= len; i++, off += rec_len) {
+        eid = ID_SIZE ? p[off + 1] | ((uint16_t)p[off + 2] << 8) : 0;
+        actual_count = store_entity(actual_count, (char)p[off], eid,
+                                    read_coord(p + off + 1 + ID_SIZE),
+                                    read_coord(p + off + 1 + ID_SIZE + COORD_SIZE));
+    }
+    state_set_other_players(actual_count);
+}
+
+/* Read n bits MSB-first; sets bit_eof instead of running off the packet */
+static uint16_t read_bits(uint8_t n) {
+    uint16_t v = 0;
+    
+    while (n--) {
+        if (bit_src >= bit_end) {
+            bit_eof = 1;
+            return 0;
+        }
+        v <<= 1;
+        if (*bit_src & bit_mask) v |= 1;
+        bit_mask >>= 1;
+        if (!bit_mask) {
+            bit_mask = 0x80;
+            bit_src++;
+        }
+    }
+    return v;
+}
+
+/* Apply a complete 0x07 packed state packet held in memory.
+ * keep: remember the records so later runs can refer to them (TCP only). */
+static void apply_packed_buffer(const uint8_t *p, uint16_t len, uint8_t keep) {
+    uint16_t count = 0;
+    uint16_t off = 3;
+    uint16_t i = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    uint8_t msgLen;
+    uint8_t xbits;
+    uint8_t ybits;
+    uint8_t idbits = 0;
+    uint8_t type;
+    uint8_t run;
+    uint16_t eid;
+    uint16_t x;
+    uint16_t y;
+    uint8_t actual_count = 0;
+    uint16_t ticks;
+    
+    do {
+        if (off >= len) return;
+        b = p[off++];
+        count |= (uint16_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 16);
+    
+    if (off + 3 > len) return;
+    ticks = p[off] | ((uint16_t)p[off + 1] << 8);
+    state_set_world_ticks(ticks);
+    msgLen = p[off + 2];
+    off += 3;
+    if (msgLen > 0 && msgLen < 40 && off + msgLen <= len) {
+        memcpy(udp_msg, p + off, msgLen);
+        udp_msg[msgLen] = '\0';
+        state_set_combat_message(udp_msg);
+    }
+    off += msgLen;
+    
+    if (off + 2 + ID_SIZE / 2 > len) return;
+    xbits = p[off];
+    ybits = p[off + 1];
+    if (ID_SIZE) {
+        idbits = p[off + 2];
+    }
+    bit_src = p + off + 2 + ID_SIZE / 2;
+    bit_end = p + len;
+    bit_mask = 0x80;
+    bit_eof = 0;
+    
+    while (i < count) {
+        if (read_bits(1)) {
+            run = (uint8_t)read_bits(PACKED_RUN_BITS) + 1;
+            if (bit_eof) break;
+            for (; run > 0 && i < count; run--, i++) {
+                if (i < PACKED_PREV_MAX) {
+                    actual_count = store_entity(actual_count, packed_types[packed_prev[i].kind],
+                                                packed_prev[i].eid, packed_prev[i].x, packed_prev[i].y);
+                }
+            }
+        } else {
+            type = (uint8_t)read_bits(2);
+            eid = read_bits(idbits);
+            x = read_bits(xbits);
+            y = read_bits(ybits);
+            if (bit_eof) break;
+            if (keep && i < PACKED_PREV_MAX) {
+                packed_prev[i].kind = type;
+                packed_prev[i].eid = eid;
+                packed_prev[i].x = x;
+                packed_prev[i].y = y;
+            }
+            actual_count = store_entity(actual_count, packed_types[type], eid, x, y);
+            i++;
+        }
+    }
+    if (keep) {
+        packed_prev_ticks = ticks;
+        packed_prev_count = bit_eof ? 0xFFFF : count; /* A cut-short packet can't be resumed from */
+    }
+    state_set_other_players(actual_count);
+}
+
+/* Drain queued datagrams, applying any snapshot newer than the last one.
+ * Returns 1 if a snapshot was applied. */
+static uint8_t udp_poll(void) {
+    uint16_t waiting;
+    uint8_t connected;
+    uint8_t err;
+    int16_t len;
+    uint16_t seq;
+    uint8_t applied = 0;
+    uint8_t n;
+    
+    for (n = 0; n < UDP_MAX_DRAIN; n++) {
+        if (network_status(udp_device_spec, &waiting, &connected, &err) != FN_ERR_OK || waiting == 0) break;
+        
+        if (waiting > sizeof(state_buf)) {
+            /* Too big for us: read it away and treat it as lost */
+            while (waiting > 0) {
+                len = network_read(udp_device_spec, state_buf, waiting > sizeof(state_buf) ? sizeof(state_buf) : waiting);
+                if (len <= 0) break;
+                waiting -= len;
+            }
+            continue;
+        }
+        
+        len = network_read(udp_device_spec, state_buf, waiting);
+        if (len < 8 || state_buf[0] != 0x11 || (state_buf[3] != 0x03 && state_buf[3] != 0x07)) continue;
+        
+        seq = state_buf[1] | ((uint16_t)state_buf[2] << 8);
+        if (udp_have_seq && (int16_t)(seq - udp_last_seq) <= 0) continue; /* Late or duplicate */
+        udp_have_seq = 1;
+        udp_last_seq = seq;
+        
+        if (state_buf[3] == 0x07) {
+            apply_packed_buffer(state_buf + 3, len - 3, 0);
+        } else {
+            apply_state_buffer(state_buf + 3, len - 3);
+        }
+        applied = 1;
+    }
+    return applied;
+}
+
 /* --- Existing Functions Modified --- */
 
+#if USE_HTTP
 static void build_device_spec(const char *path) {
     snprintf(device_spec, DEVICE_SPEC_SIZE, "N:HTTP://%s:%d%s", SERVER_HOST, SERVER_PORT, path);
 }
+#endif
 
 /* Helper functions moved to json_helpers.c */
 
 uint8_t kz_network_init(void) {
     printf("Network init...\n");
+    proceed_init();
     /* If we are using TCP, we might want to establish connection later or check availability */
     current_status = NET_CONNECTED;
     return 0;
 }
 
 uint8_t kz_network_close(void) {
+    udp_close();
     tcp_disconnect();
+    proceed_done();
     current_status = NET_DISCONNECTED;
     return 0;
 }
@@ -88,6 +704,143 @@ uint8_t kz_network_health_check(void) {
     return 0;
 }
 
+/* Fill in the fields every join path sets the same way and publish the player */
+static void join_complete(player_state_t *player, const char *name) {
+    strncpy(player->name, name, sizeof(player->name) - 1);
+    player->name[sizeof(player->name) - 1] = '\0';
+    strcpy(player->status, "alive");
+    strcpy(player->type, "player");
+    player->isHunter = 0;
+    state_set_local_player(player);
+}
+
+/* Decode a 0x08 connect reply (also the answer to a successful 0x09 resume):
+ * 0x08 [LenLo] [LenHi] [Version] [CapsLo] [CapsHi] [WidthLo] [WidthHi] [HeightLo] [HeightHi]
+ *    [IDLen] [ID] [X] [Y] [Health] [VerLen] [Version] ([TokenLen] [Token] with RESUME)
+ *    ([UdpPortLo] [UdpPortHi] with UDP) [0x03 or 0x07 state packet]
+ * The reply is read with two network_read calls and decoded in memory. */
+static uint8_t tcp_read_connect_reply(const char *name, player_state_t *player) {
+    uint8_t *p = state_buf + 3;
+    uint16_t bodyLen;
+    uint16_t off;
+    uint8_t idLen;
+    uint8_t verLen;
+    uint8_t saved;
+    int len;
+    
+    len = tcp_read_frame();
+    if (len < 8 || state_buf[0] != 0x08) return 0;
+    bodyLen = (uint16_t)len;
+    
+    protocol_version = p[0];
+    codec_caps = p[1];
+    state_set_world_dimensions(p[3] | ((uint16_t)p[4] << 8), p[5] | ((uint16_t)p[6] << 8));
+    declared_view_w = DISPLAY_WIDTH;
+    declared_view_h = DISPLAY_HEIGHT;
+    
+    idLen = p[7];
+    off = 8;
+    if (idLen >= sizeof(player->id) || off + idLen + COORD_SIZE * 2 + 2 > bodyLen) return 0;
+    memcpy(player->id, p + off, idLen);
+    player->id[idLen] = '\0';
+    off += idLen;
+    player->x = read_coord(p + off);
+    player->y = read_coord(p + off + COORD_SIZE);
+    player->health = p[off + COORD_SIZE * 2];
+    off += COORD_SIZE * 2 + 1;
+    
+    verLen = p[off++];
+    if (off + verLen > bodyLen) return 0;
+    if (verLen > 0 && verLen < 16) {
+        saved = p[off + verLen];
+        p[off + verLen] = '\0';
+        state_set_server_version((char*)(p + off));
+        p[off + verLen] = saved;
+    }
+    off += verLen;
+    
+    resume_token_len = 0;
+    if (codec_caps & CAP_RESUME) {
+        if (off >= bodyLen || p[off] > sizeof(resume_token) || off + 1 + p[off] > bodyLen) return 0;
+        resume_token_len = p[off];
+        memcpy(resume_token, p + off + 1, resume_token_len);
+        off += 1 + resume_token_len;
+    }
+    if (codec_caps & CAP_UDP) {
+        if (off + 2 > bodyLen) return 0;
+        udp_port = p[off] | ((uint16_t)p[off + 1] << 8);
+        off += 2;
+    }
+    
+    /* The local player must be known before the snapshot's 'M' record */
+    join_complete(player, name);
+    if (off < bodyLen && p[off] == 0x07) {
+        apply_packed_buffer(p + off, bodyLen - off, 1);
+    } else if (off < bodyLen && p[off] == 0x03) {
+        apply_state_buffer(p + off, bodyLen - off);
+    }
+    return 1;
+}
+
+/* Connect, join and get the first frame in one round trip:
+ * 0x08 [Version] [CapsLo] [CapsHi] [ViewW] [ViewH] [NameLen] [Name]
+ * Servers before version 5 never answer, so this fails once the read times out. */
+static uint8_t tcp_connect_join(const char *name, player_state_t *player) {
+    uint8_t *p = state_buf;
+    uint8_t nameLen = (uint8_t)strlen(name);
+    
+    p[0] = 0x08;
+    p[1] = PROTOCOL_VERSION;
+    p[2] = CLIENT_CAPS;
+    p[3] = 0;
+    p[4] = DISPLAY_WIDTH;
+    p[5] = DISPLAY_HEIGHT;
+    p[6] = nameLen;
+    memcpy(p + 7, name, nameLen);
+    if (network_write(tcp_device_spec, p, 7 + nameLen) != FN_ERR_OK) return 0;
+    
+    return tcp_read_connect_reply(name, player);
+}
+
+/* Reconnect after the link dropped and pick the session back up:
+ * 0x09 [Version] [CapsLo] [CapsHi] [ViewW] [ViewH] [TicksLo] [TicksHi] [CountLo] [CountHi]
+ *      [TokenLen] [Token]
+ * Ticks and Count name the last packed state we applied, so the server can keep
+ * sending runs against it. A refused token (0x09 [0] [0]) falls back to a join by name. */
+static uint8_t tcp_resume(void) {
+    static char name[PLAYER_NAME_MAX];
+    player_state_t *local = (player_state_t *)state_get_local_player();
+    uint8_t *p = state_buf;
+    
+    if (!local) return 0;
+    strncpy(name, local->name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    
+    tcp_disconnect();
+    if (!tcp_connect()) return 0;
+    
+    if (resume_token_len) {
+        p[0] = 0x09;
+        p[1] = PROTOCOL_VERSION;
+        p[2] = CLIENT_CAPS;
+        p[3] = 0;
+        p[4] = DISPLAY_WIDTH;
+        p[5] = DISPLAY_HEIGHT;
+        p[6] = (uint8_t)packed_prev_ticks;
+        p[7] = (uint8_t)(packed_prev_ticks >> 8);
+        p[8] = (uint8_t)packed_prev_count;
+        p[9] = (uint8_t)(packed_prev_count >> 8);
+        p[10] = resume_token_len;
+        memcpy(p + 11, resume_token, resume_token_len);
+        if (network_write(tcp_device_spec, p, 11 + resume_token_len) == FN_ERR_OK &&
+            tcp_read_connect_reply(name, local)) {
+            return 1;
+        }
+        resume_token_len = 0;
+    }
+    return tcp_connect_join(name, local);
+}
+
 /* TCP Join Implementation */
 static uint8_t kz_network_join_player_tcp(const char *name, player_state_t *player) {
     /* Large buffer must be static to avoid stack overflow in cc65 */
@@ -99,34 +852,58 @@ static uint8_t kz_network_join_player_tcp(const char *name, player_state_t *play
         if (!tcp_connect()) return 0;
     }
     
-    /* Packet: 0x01 [NameLen] [Name] */
-    len = strlen(name);
-    buf[0] = 0x01;
-    buf[1] = (uint8_t)len;
-    memcpy(&buf[2], name, len);
-    
-    if (network_write(tcp_device_spec, buf, 2 + len) != FN_ERR_OK) return 0;
+    if (tcp_connect_join(name, player)) {
+        udp_follow_caps();
+        return 1;
+    }
     
-    /* Read Response: 0x01 [IDLen] [ID] [X] [Y] [Health] */
-    /* Read header first */
-    len = network_read(tcp_device_spec, buf, 2); 
-    if (len < 2 || buf[0] != 0x01) return 0;
+    /* Older server: start over on a fresh connection with hello + join */
+    tcp_disconnect();
+    if (!tcp_connect()) return 0;
+    declared_view_w = 0;
+    declared_view_h = 0;
+    tcp_hello();
     
-    idLen = buf[1];
+    len = strlen(name);
+    if (protocol_version >= 4) {
+        /* Packet: 0x06 [CapsLo] [CapsHi] [NameLen] [Name] */
+        buf[0] = 0x06;
+        buf[1] = CLIENT_CAPS & ~(CAP_FRAMED | CAP_RESUME | CAP_UDP); /* Reply below is read piecewise */
+        buf[2] = 0;
+        buf[3] = (uint8_t)len;
+        memcpy(&buf[4], name, len);
+        if (network_write(tcp_device_spec, buf, 4 + len) != FN_ERR_OK) return 0;
+        
+        /* Read Response: 0x06 [CapsLo] [CapsHi] [IDLen] [ID] [X] [Y] [Health] */
+        len = network_read(tcp_device_spec, buf, 4);
+        if (len < 4 || buf[0] != 0x06) return 0;
+        codec_caps = buf[1];
+        idLen = buf[3];
+    } else {
+        /* Packet: 0x01 [NameLen] [Name] */
+        buf[0] = 0x01;
+        buf[1] = (uint8_t)len;
+        memcpy(&buf[2], name, len);
+        if (network_write(tcp_device_spec, buf, 2 + len) != FN_ERR_OK) return 0;
+        
+        /* Read Response: 0x01 [IDLen] [ID] [X] [Y] [Health] */
+        len = network_read(tcp_device_spec, buf, 2);
+        if (len < 2 || buf[0] != 0x01) return 0;
+        idLen = buf[1];
+    }
     /* Read ID */
     len = network_read(tcp_device_spec, buf, idLen);
     if (len != idLen) return 0;
     memcpy(player->id, buf, idLen);
     player->id[idLen] = '\0';
-    strncpy(player->name, name, sizeof(player->name));
     
     /* Read data: X, Y, Health */
-    len = network_read(tcp_device_spec, buf, 3);
-    if (len != 3) return 0;
+    len = network_read(tcp_device_spec, buf, COORD_SIZE * 2 + 1);
+    if (len != COORD_SIZE * 2 + 1) return 0;
     
-    player->x = buf[0];
-    player->y = buf[1];
-    player->health = buf[2];
+    player->x = read_coord(buf);
+    player->y = read_coord(buf + COORD_SIZE);
+    player->health = buf[COORD_SIZE * 2];
     
     /* Read server version: [VerLen] [Version] */
     len = network_read(tcp_device_spec, buf, 1);
@@ -139,11 +916,8 @@ static uint8_t kz_network_join_player_tcp(const char *name, player_state_t *play
         }
     }
     
-    strcpy(player->status, "alive");
-    strcpy(player->type, "player");
-    player->isHunter = 0;
-    
-    state_set_local_player(player);
+    join_complete(player, name);
+    udp_follow_caps(); /* No 0x08 reply, so no UDP: this closes any old channel */
     return 1;
 }
 
@@ -152,10 +926,53 @@ uint8_t kz_network_join_player(const char *name, player_state_t *player) {
     return 0; 
 }
 
+/* Predicted move: 0x0B [Seq] [Dir], or a place in the next batch. Returns the
+ * predicted position at once; the reply is applied by whichever read comes
+ * across it. */
+static uint8_t tcp_move_predicted(char dirChar, move_result_t *result) {
+    uint8_t buf[3];
+    player_state_t *local = (player_state_t *)state_get_local_player();
+    
+    if (!local) return 0;
+    if (pred_pending == PREDICT_MAX) {
+        /* Too far ahead of the server: take in any answers, and drop the
+         * keypress rather than wait if none has come */
+        kz_network_pump();
+        if (pred_pending == PREDICT_MAX) return 0;
+    }
+    
+    if (USE_BATCH) {
+        if (batch_count == 0) {
+            move_batch[0] = 0x0C;
+            move_batch[1] = (uint8_t)(move_seq + 1);
+        }
+        move_batch[3 + batch_count++] = (uint8_t)dirChar;
+    } else {
+        buf[0] = 0x0B;
+        buf[1] = (uint8_t)(move_seq + 1);
+        buf[2] = (uint8_t)dirChar;
+        if (network_write(tcp_device_spec, buf, 3) != FN_ERR_OK) return 0;
+    }
+    move_seq++;
+    pred_dir[move_seq & (PREDICT_MAX - 1)] = dirChar;
+    pred_pending++;
+    
+    predict_step(dirChar, &local->x, &local->y);
+    result->x = local->x;
+    result->y = local->y;
+    result->collision = 0;
+    result->message_count = 0;
+    result->loser_id[0] = '\0';
+    return 1;
+}
+
 /* TCP Move Implementation */
 static uint8_t kz_network_move_player_tcp(const char *player_id, const char *direction, move_result_t *result) {
-    uint8_t buf[16];
+    uint8_t buf[48];
     int len;
+    int hdr;
+    const uint8_t *m;
+    int framed_len = 0;
     const player_state_t *local;
     char dirChar = 'x';
     if (strcmp(direction, "up") == 0) dirChar = 'u';
@@ -164,6 +981,7 @@ static uint8_t kz_network_move_player_tcp(const char *player_id, const char *dir
     if (strcmp(direction, "right") == 0) dirChar = 'r';
     
     if (!tcp_connected) return 0;
+    if (USE_PREDICTION) return tcp_move_predicted(dirChar, result);
     
     /* Packet: 0x02 [DirChar] */
     buf[0] = 0x02;
@@ -172,29 +990,46 @@ static uint8_t kz_network_move_player_tcp(const char *player_id, const char *dir
     if (network_write(tcp_device_spec, buf, 2) != FN_ERR_OK) return 0;
     
     /* Resp: 0x02 [X] [Y] [Health] [Collision] [MsgLen] [Msg...] */
-    len = network_read(tcp_device_spec, buf, 6);
-    if (len < 6 || buf[0] != 0x02) return 0;
+    hdr = 4 + COORD_SIZE * 2;
+    if (codec_caps & CAP_FRAMED) {
+        /* Framed: the whole reply, message included, in one frame */
+        len = tcp_read_frame();
+        if (len < hdr - 1 || state_buf[0] != 0x02) return 0;
+        state_buf[2] = 0x02;
+        m = state_buf + 2;
+        framed_len = len + 1;
+    } else {
+        len = network_read(tcp_device_spec, buf, hdr);
+        if (len < hdr || buf[0] != 0x02) return 0;
+        m = buf;
+    }
     
-    result->x = buf[1];
-    result->y = buf[2];
+    result->x = read_coord(m + 1);
+    result->y = read_coord(m + 1 + COORD_SIZE);
     /* Update local player health too? */
     local = state_get_local_player();
     if (local) {
-        ((player_state_t*)local)->health = buf[3];
+        ((player_state_t*)local)->health = m[hdr - 3];
         ((player_state_t*)local)->x = result->x;
         ((player_state_t*)local)->y = result->y;
     }
     
-    result->collision = buf[4];
+    result->collision = m[hdr - 2];
     result->message_count = 0;
     
     /* Read battle message if present */
     {
-        uint8_t msgLen = buf[5];
+        uint8_t msgLen = m[hdr - 1];
         if (msgLen > 0 && msgLen < 40) {
-            len = network_read(tcp_device_spec, buf, msgLen);
+            if (framed_len) {
+                len = framed_len >= hdr + msgLen ? msgLen : 0;
+                m += hdr;
+            } else {
+                len = network_read(tcp_device_spec, buf, msgLen);
+                m = buf;
+            }
             if (len == msgLen) {
-                memcpy(result->messages[0], buf, msgLen);
+                memcpy(result->messages[0], m, msgLen);
                 result->messages[0][msgLen] = '\0';
                 result->message_count = 1;
                 /* Store in state for non-blocking display */
@@ -211,91 +1046,217 @@ uint8_t kz_network_move_player(const char *player_id, const char *direction, mov
     return 0;
 }
 
+uint8_t kz_network_flush_moves(void) {
+    uint8_t count = batch_count;
+    
+    if (count == 0 || !tcp_connected) return 1;
+    batch_count = 0;
+    move_batch[2] = count;
+    return network_write(tcp_device_spec, move_batch, 3 + count) == FN_ERR_OK;
+}
+
 uint8_t kz_network_leave_player(const char *player_id) {
+    resume_token_len = 0;
+    udp_close();
     tcp_disconnect();
     return 1;
 }
 
-static player_state_t other_players[MAX_OTHER_PLAYERS];
+uint8_t kz_network_set_viewport(uint8_t width, uint8_t height) {
+    uint8_t buf[3];
+    
+    if (!tcp_connected) return 0;
+    if (width == declared_view_w && height == declared_view_h) return 1;
+    
+    /* Packet: 0x04 [Width] [Height] - no response */
+    buf[0] = 0x04;
+    buf[1] = width;
+    buf[2] = height;
+    
+    if (network_write(tcp_device_spec, buf, 3) != FN_ERR_OK) return 0;
+    declared_view_w = width;
+    declared_view_h = height;
+    return 1;
+}
 
-uint8_t kz_network_get_world_state(void) {
-    if (USE_TCP) {
-        static uint8_t buf[256]; /* Large buffer static */
-        int len;
-        uint8_t count;
-        uint8_t i;
-        uint8_t actual_count = 0;
-        char typeChar;
-        uint8_t x, y;
-        const player_state_t *local;
-        uint8_t msgLen;
-
-        if (!tcp_connected) return 0;
-        
-        buf[0] = 0x03;
-        if (network_write(tcp_device_spec, buf, 1) != FN_ERR_OK) return 0;
-        
-        /* Resp: 0x03 [Count] [TicksLow] [TicksHigh] [MsgLen] [Msg...] [Entities...] */
-        len = network_read(tcp_device_spec, buf, 5);
-        if (len < 5 || buf[0] != 0x03) return 0;
-        
-        count = buf[1];
-        {
-            uint16_t ticks = buf[2] | (buf[3] << 8);
-            state_set_world_ticks(ticks);
+/* Poll state over TCP: 0x03 -> [Count] [TicksLow] [TicksHigh] [MsgLen] [Msg...] [Entities...],
+ * or a packed 0x07 reply. Framed and packed replies are read whole and decoded in memory. */
+static uint8_t tcp_get_world_state(void) {
+    static uint8_t buf[256]; /* Large buffer static */
+    int len;
+    uint8_t count;
+    uint8_t i;
+    uint8_t actual_count = 0;
+    uint8_t rec_len = 1 + ID_SIZE + COORD_SIZE * 2;
+    uint8_t msgLen;
+
+    if (!tcp_connected) return 0;
+    
+    buf[0] = 0x03;
+    if (network_write(tcp_device_spec, buf, 1) != FN_ERR_OK) return 0;
+    
+    if (codec_caps & (CAP_PACKED | CAP_FRAMED)) {
+        len = tcp_read_reply();
+        if (len < 0) return 0;
+        if (state_buf[0] == 0x07) {
+            apply_packed_buffer(state_buf, 3 + len, 1);
+        } else if (state_buf[0] == 0x03) {
+            /* Move the type up against the body to get a plain 0x03 packet */
+            state_buf[2] = 0x03;
+            apply_state_buffer(state_buf + 2, 1 + len);
+        } else {
+            return 0;
         }
-        
-        /* Read message if present */
-        msgLen = buf[4];
-        if (msgLen > 0 && msgLen < 40) {
-            len = network_read(tcp_device_spec, buf, msgLen);
-            if (len == msgLen) {
-                buf[msgLen] = '\0';
-                state_set_combat_message((char*)buf);
-            }
+        return 1;
+    }
+    
+    len = network_read(tcp_device_spec, buf, 5);
+    if (len < 5 || buf[0] != 0x03) return 0;
+    
+    count = buf[1];
+    {
+        uint16_t ticks = buf[2] | (buf[3] << 8);
+        state_set_world_ticks(ticks);
+    }
+    
+    /* Read message if present */
+    msgLen = buf[4];
+    if (msgLen > 0 && msgLen < 40) {
+        len = network_read(tcp_device_spec, buf, msgLen);
+        if (len == msgLen) {
+            buf[msgLen] = '\0';
+            state_set_combat_message((char*)buf);
         }
+    }
+    
+    for (i = 0; i < count; i++) {
+        /* Read record: Type, [Id], X, Y */
+        len = network_read(tcp_device_spec, buf, rec_len);
+        if (len < rec_len) break;
         
-        local = state_get_local_player();
+        actual_count = store_entity(actual_count, (char)buf[0],
+                                    ID_SIZE ? buf[1] | ((uint16_t)buf[2] << 8) : 0,
+                                    read_coord(buf + 1 + ID_SIZE),
+                                    read_coord(buf + 1 + ID_SIZE + COORD_SIZE));
+    }
+    
+    state_set_other_players(actual_count);
+    return 1;
+}
+
+/* Apply one reply assembled by tcp_poll_frame */
+static void tcp_dispatch_frame(int len) {
+    switch (state_buf[0]) {
+        case 0x0B:
+            apply_move_ack(len);
+            break;
+        case 0x0A:
+            if (len >= 9) apply_pong(state_buf + 2);
+            break;
+        case 0x07:
+            apply_packed_buffer(state_buf, 3 + len, 1);
+            state_inflight = 0;
+            break;
+        case 0x03:
+            /* Move the type up against the body to get a plain 0x03 packet */
+            state_buf[2] = 0x03;
+            apply_state_buffer(state_buf + 2, 1 + len);
+            state_inflight = 0;
+            break;
+    }
+}
+
+/* Send a state request unless one is already in flight. Returns 0 if the write failed. */
+static uint8_t tcp_request_state(void) {
+    uint8_t req = 0x03;
+    
+    if (state_inflight) return 1;
+    if (network_write(tcp_device_spec, &req, 1) != FN_ERR_OK) return 0;
+    state_inflight = 1;
+    return 1;
+}
+
+uint8_t kz_network_pump(void) {
+    int len;
+    uint8_t n;
+    uint8_t announced;
+    
+    if (!USE_TCP || !tcp_connected || !USE_NONBLOCKING) return 0;
+    kz_network_flush_moves(); /* Anything queued since the last flush goes first */
+    
+    announced = proceed_trip || rx_more;
+    if (!proceed_ok || announced || ++quiet_frames >= PROCEED_CHECK_FRAMES) {
+        quiet_frames = 0;
+        proceed_ack(); /* Data arriving from here on raises it again */
         
-        for (i = 0; i < count; i++) {
-            /* Read 3 bytes: Type, X, Y */
-            len = network_read(tcp_device_spec, buf, 3);
-            if (len < 3) break;
-            
-            typeChar = (char)buf[0];
-            x = buf[1];
-            y = buf[2];
-            
-            if (typeChar == 'M') {
-                /* Me / Local Player - update if moved externally? */
-                if (local) {
-                     ((player_state_t*)local)->x = x;
-                     ((player_state_t*)local)->y = y;
+        for (n = 0; n < PUMP_MAX_FRAMES; n++) {
+            len = tcp_poll_frame();
+            if (len == -1) break;
+            if (len < 0) {
+                /* The link dropped under us: resume the session (this one blocks) */
+                if (tcp_resume()) {
+                    udp_follow_caps();
                 }
-                continue;
+                return tcp_connected;
             }
-            
-            if (actual_count < MAX_OTHER_PLAYERS) {
-                player_state_t *p = &other_players[actual_count];
-                /* We don't have ID or Name in simplified packet, just position/type */
-                /* This is a limitation of the simplified protocol, we just render them blindly */
-                /* For full feature parity we need IDs */
-                /* But for "bouncy" style, it's just visual. */
-                p->x = x;
-                p->y = y;
-                p->isHunter = (typeChar == 'H');
-                
-                if (typeChar == 'P') strcpy(p->type, "player");
-                else strcpy(p->type, "mob");
-                
-                actual_count++;
+            tcp_dispatch_frame(len);
+            if (!announced) {
+                proceed_ok = 0; /* A whole reply came in unannounced */
             }
         }
-        
-        state_set_other_players(other_players, actual_count);
+        rx_more = n == PUMP_MAX_FRAMES;
+    }
+    
+    /* Pipeline: the next request goes out as soon as the last reply is in */
+    if (tcp_streaming && !state_inflight) {
+        tcp_request_state();
+    }
+    return 1;
+}
+
+uint8_t kz_network_get_world_state(void) {
+    if (!USE_TCP) return 0;
+    
+    if (pred_pending > 0 && tcp_connected && !USE_NONBLOCKING) {
+        tcp_drain_acks();
+    }
+    if (protocol_version >= 6 && tcp_connected) {
+        if (ping_countdown == 0) {
+            ping_countdown = PING_INTERVAL_POLLS;
+            tcp_ping();
+        }
+        ping_countdown--;
+    }
+    
+    tcp_streaming = 0;
+    if (USE_UDP && udp_open) {
+        if (++udp_keepalive >= UDP_KEEPALIVE_POLLS) {
+            udp_keepalive = 0;
+            udp_subscribe();
+        }
+        if (udp_poll()) {
+            udp_idle_polls = 0;
+            return 1;
+        }
+        /* Nothing new yet: keep the last snapshot unless UDP looks dead */
+        if (udp_idle_polls < UDP_FALLBACK_POLLS) {
+            udp_idle_polls++;
+            return 1;
+        }
+        udp_have_seq = 0; /* Accept a restarted server's sequence when datagrams resume */
+    }
+    if (USE_NONBLOCKING && tcp_connected) {
+        /* kz_network_pump takes the reply in; just keep a request in flight */
+        tcp_streaming = 1;
+        if (tcp_request_state()) return 1;
+    } else if (tcp_get_world_state()) {
         return 1;
     }
-    return 0;
+    
+    /* The link dropped under us (not a deliberate leave): resume the session */
+    if (!tcp_connected || !tcp_resume()) return 0;
+    udp_follow_caps();
+    return 1;
 }
 
 uint8_t kz_network_get_player_status(const char *player_id, player_state_t *player) {
@@ -0,0 +1,22 @@
+/**
+ * KillZone PROCEED Interrupt - Atari 8-bit
+ *
+ * The FujiNet pulls the SIO PROCEED line when a network channel has data
+ * waiting. proceed_init hooks that interrupt (VPRCED) so the network layer
+ * only asks the FujiNet for bytes once it has said there are some, instead
+ * of polling it over SIO every frame.
+ */
+
+#ifndef KILLZONE_PROCEED_H
+#define KILLZONE_PROCEED_H
+
+#include <stdint.h>
+
+/* Set by the interrupt handler; the PROCEED interrupt stays off until proceed_ack */
+extern volatile uint8_t proceed_trip;
+
+void proceed_init(void);  /* Hook VPRCED and enable the interrupt */
+void proceed_done(void);  /* Disable it and restore the old vector */
+void proceed_ack(void);   /* Clear proceed_trip and enable the interrupt again */
+
+#endif /* KILLZONE_PROCEED_H */
@@ -0,0 +1,67 @@
+        .export         _proceed_init
+        .export         _proceed_done
+        .export         _proceed_ack
+        .export         _proceed_trip
+
+        .include        "atari.inc"
+
+; The FujiNet raises PROCEED (PIA CA1) when a network channel has data
+; waiting. The OS IRQ handler pushes A and jumps through VPRCED; ours notes
+; the event, turns the interrupt off so a held line can't storm, and
+; returns. The main loop reads the data, then calls proceed_ack.
+
+        .bss
+_proceed_trip:  .res    1
+old_vprced:     .res    2
+
+        .code
+
+; void proceed_init(void)
+_proceed_init:
+        lda     #0
+        sta     _proceed_trip
+        sei
+        lda     VPRCED
+        sta     old_vprced
+        lda     VPRCED+1
+        sta     old_vprced+1
+        lda     #<handler
+        sta     VPRCED
+        lda     #>handler
+        sta     VPRCED+1
+        cli
+        ; fall through
+
+; void proceed_ack(void)
+_proceed_ack:
+        lda     #0
+        sta     _proceed_trip
+        lda     PACTL
+        ora     #$01            ; enable the PROCEED interrupt
+        sta     PACTL
+        rts
+
+; void proceed_done(void)
+_proceed_done:
+        lda     PACTL
+        and     #$FE
+        sta     PACTL
+        lda     old_vprced+1
+        beq     done            ; never hooked
+        sei
+        lda     old_vprced
+        sta     VPRCED
+        lda     old_vprced+1
+        sta     VPRCED+1
+        cli
+done:   rts
+
+handler:
+        lda     PACTL
+        and     #$FE            ; off until the main loop has looked
+        sta     PACTL
+        lda     PORTA           ; reading port A clears the interrupt flag
+        lda     #1
+        sta     _proceed_trip
+        pla
+        rti
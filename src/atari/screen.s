@@ -0,0 +1,68 @@
+        .export         _screen_put_span
+        .export         _screen_page
+
+        .import         popa
+        .import         popax
+
+        .importzp       ptr1
+        .importzp       ptr2
+        .importzp       tmp1
+        .importzp       tmp2
+
+; void __fastcall__ screen_put_span(uint8_t x, uint8_t y, const char *s, uint8_t len)
+;
+; Store len ATASCII chars as screen codes straight into the play-area page at
+; _screen_page (the hidden page, set by double_buffer.c).
+; No cursor update, no control codes, no CIO: about 25 cycles a character.
+
+_screen_put_span:
+        sta     tmp1            ; len
+        jsr     popax
+        sta     ptr1            ; s
+        stx     ptr1+1
+        jsr     popa
+        sta     tmp2            ; y
+        jsr     popa            ; x
+
+        ; ptr2 = _screen_page + y * 40 + x
+        ldy     tmp2
+        clc
+        adc     mul40_lo, y
+        sta     ptr2
+        lda     mul40_hi, y
+        adc     #0
+        sta     ptr2+1
+        clc
+        lda     ptr2
+        adc     _screen_page
+        sta     ptr2
+        lda     ptr2+1
+        adc     _screen_page+1
+        sta     ptr2+1
+
+        ldx     tmp1
+        beq     done
+        ldy     #0
+loop:   lda     (ptr1), y
+        ; convert char to screen code, as cputc does
+        asl     a               ; shift out the inverse bit
+        adc     #$c0            ; grab the inverse bit; convert ATASCII to screen code
+        bpl     codeok          ; screen code ok?
+        eor     #$40            ; needs correction
+codeok: lsr     a               ; undo the shift
+        bcc     store
+        eor     #$80            ; restore the inverse bit
+store:  sta     (ptr2), y
+        iny
+        dex
+        bne     loop
+done:   rts
+
+.bss
+_screen_page:   .res 2
+
+.rodata
+.define mul40_table $0000, $0028, $0050, $0078, $00A0, $00C8, $00F0, $0118, $0140, $0168, $0190, $01B8, $01E0, $0208, $0230, $0258, $0280, $02A8, $02D0, $02F8, $0320, $0348, $0370, $0398
+
+mul40_lo:       .lobytes mul40_table
+mul40_hi:       .hibytes mul40_table
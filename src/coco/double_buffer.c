@@ -0,0 +1,31 @@
+#include <cmoc.h>
+#include <coco.h>
+#include "double_buffer.h"
+
+/*
+ * Double buffer for the coco
+ *
+ * One page: hirestxt draws straight into the visible PMODE 4 bitmap, so
+ * frames are drawn in place, as in the bouncy sample.
+ */
+
+void dbuf_init(void)
+{
+}
+
+void dbuf_close(void)
+{
+}
+
+void dbuf_reset(void)
+{
+}
+
+uint8_t dbuf_hidden(void)
+{
+  return 0;
+}
+
+void dbuf_flip(void)
+{
+}
@@ -0,0 +1,28 @@
+#include <cmoc.h>
+#include <coco.h>
+#include <hirestxt.h>
+#include "conio_wrapper.h"
+#include "screen.h"
+
+/*
+ * Screen backend for the coco
+ *
+ * On a CoCo 1/2 the text screen is the hirestxt PMODE 4 bitmap, so spans go
+ * straight to its glyph blitter, skipping printf, the cursor and scrolling.
+ * The CoCo 3 runs a hardware 40 column screen and keeps using conio.
+ */
+
+void screen_put_span(uint8_t x, uint8_t y, const char *s, uint8_t len)
+{
+  if (isCoCo3)
+  {
+    gotoxy(x, y);
+    putstr(s, len);
+    return;
+  }
+
+  while (len--)
+  {
+    writeCharAt_42cols(x++, y, (byte)*s++);
+  }
+}
@@ -25,9 +25,19 @@
 #define CHAR_WALL '#'
 
 /* Player Limits */
-#define MAX_OTHER_PLAYERS 10
+#define MAX_OTHER_PLAYERS 100  /* Remote entities kept from one snapshot (7 bytes each, see entity_t) */
 #define PLAYER_NAME_MAX 32
 
+/* Input */
+#define MAX_KEYS_PER_FRAME 8  /* Queued keys taken in one frame; their moves go out as one batch */
+
+/* Frame pacing (see frame.h): periods in jiffies, budgets in percent of a frame */
+#define STATE_POLL_JIFFIES 5   /* Ask for world state this often */
+#define STATUS_JIFFIES 10      /* Redraw the status bar this often */
+#define NET_BUDGET 50          /* A state poll due later than this waits for the next frame */
+#define RENDER_BUDGET 100      /* Past this the play area is skipped for a frame to catch up */
+#define STATUS_BUDGET 75       /* A status redraw due later than this waits for the next frame */
+
 /* Server Configuration */
 #define SERVER_HOST "127.0.0.1"
 #define SERVER_PORT 3000
@@ -7,24 +7,118 @@
 
 #include "display.h"
 #include "network.h"
+#include "screen.h"
+#include "double_buffer.h"
 #include <stdio.h>
 #include <string.h>
 #include <conio.h>
 
-/* Direct drawing to screen, no buffer needed */
+/* Shadow of the play area. Each frame is composed into screen_back and
+ * compared with screen_front, the characters already in the page being drawn
+ * (double_buffer.h); only cells that differ are written, a run at a time,
+ * through the target's direct screen-memory backend (screen.h), and the page
+ * is then flipped into view. A 0 in screen_front never matches a glyph, so
+ * zeroing it makes the next frames rewrite every cell. */
+#define RUN_GAP 3 /* Unchanged cells a run may span, to save a gotoxy */
+static char screen_front[DBUF_PAGES][DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static char screen_back[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+
+/* The entities each page shows, keyed by id in a small open-addressed
+ * table (linear probing, eid 0 = empty slot); off-screen entities are left
+ * out. A frame compares its entities with the hidden page's table and only
+ * rescans the rows where one appeared, moved, changed glyph or left.
+ * Without ids, or after a clear or a camera move, every row is rescanned. */
+#define DRAWN_SLOTS 128 /* Power of two above MAX_OTHER_PLAYERS */
+#define NO_CELL 0xFFFF  /* Off screen */
+#define SEEN_CELL 0xFFFE
+typedef struct {
+    uint16_t eid;
+    uint16_t cell;  /* sy * DISPLAY_WIDTH + sx */
+    char glyph;
+} drawn_t;
+static drawn_t drawn[DBUF_PAGES][DRAWN_SLOTS];
+static drawn_t drawn_prev[DRAWN_SLOTS];
+static uint16_t drawn_player[DBUF_PAGES];
+static uint16_t drawn_cam_x[DBUF_PAGES];
+static uint16_t drawn_cam_y[DBUF_PAGES];
+static uint8_t drawn_valid[DBUF_PAGES];
+static uint8_t row_dirty[DISPLAY_HEIGHT];
+static uint8_t pages_differ = 0;
+
+/**
+ * Clear the screen and forget what the play area showed
+ */
+static void clear_screen(void) {
+    clrscr();
+    dbuf_reset();
+    memset(screen_front, 0, sizeof(screen_front));
+    memset(drawn_valid, 0, sizeof(drawn_valid));
+}
+
+/**
+ * Write every cell of the dirty rows where screen_back differs from the
+ * hidden page, then show it
+ */
+static void flush_screen(void) {
+    char *page = screen_front[dbuf_hidden()];
+    char *back;
+    char *front;
+    uint8_t x, y;
+    uint8_t start, end;
+    uint8_t written = 0;
+    
+    for (y = 0; y < DISPLAY_HEIGHT; y++) {
+        if (!row_dirty[y]) {
+            continue;
+        }
+        back = screen_back + y * DISPLAY_WIDTH;
+        front = page + y * DISPLAY_WIDTH;
+        x = 0;
+        while (x < DISPLAY_WIDTH) {
+            if (back[x] == front[x]) {
+                x++;
+                continue;
+            }
+            
+            /* Extend the run while the next change is no more than RUN_GAP cells away */
+            start = x;
+            end = ++x;
+            while (x < DISPLAY_WIDTH && x - end <= RUN_GAP) {
+                if (back[x] != front[x]) {
+                    end = x + 1;
+                }
+                x++;
+            }
+            x = end;
+            
+            memcpy(front + start, back + start, end - start);
+            screen_put_span(start, y, back + start, end - start);
+            written = 1;
+        }
+    }
+    
+    /* The page in view lags one frame behind when the last flip changed
+     * something, so a frame that matched the hidden page is still shown */
+    if (written || pages_differ) {
+        dbuf_flip();
+    }
+    pages_differ = written;
+}
 
 /**
  * Initialize display system
  */
 void display_init(void) {
-    clrscr();  /* Clear screen using conio */
+    dbuf_init();
+    clear_screen();  /* Clear screen using conio */
 }
 
 /**
  * Close display system
  */
 void display_close(void) {
-    clrscr();
+    clear_screen();
+    dbuf_close();
 }
 
 /**
@@ -34,7 +128,7 @@ void display_show_welcome(const char *server_name) {
     static char url_buf[60];
     (void)server_name; /* Suppress unused warning */
     
-    clrscr();
+    clear_screen();
     gotoxy(0, 4);
     printf("  *** KILLZONE ***\n");
     gotoxy(0, 5);
@@ -59,13 +153,15 @@ void display_show_welcome(const char *server_name) {
 /**
  * Draw status bar (last 4 lines of screen)
  * 
- * Shows: player name, player count, connection status, world ticks
+ * Shows: player name, player count, connection status, round-trip time, world ticks
  * Uses cputsxy for direct character placement without scrolling
  */
 void display_draw_status_bar(const char *player_name, uint8_t player_count, 
                              const char *connection_status, uint16_t world_ticks) {
     static char line_buf[41];
     static char ticks_buf[11];
+    static char rtt_buf[8];
+    uint16_t rtt;
     static char ver_buf[16];
     const char *server_ver;
     
@@ -80,6 +176,13 @@ void display_draw_status_bar(const char *player_name, uint8_t player_count,
     snprintf(ticks_buf, sizeof(ticks_buf), "T:%d", world_ticks);
     cputsxy(30, 20, ticks_buf);
     
+    /* Round-trip time just left of the ticks, once a ping has been answered */
+    rtt = state_get_rtt();
+    if (rtt > 0) {
+        snprintf(rtt_buf, sizeof(rtt_buf), "R:%-4u", rtt > 9999 ? 9999 : rtt);
+        cputsxy(23, 20, rtt_buf);
+    }
+    
     /* Line 21: Clear for server messages (combat, kills, etc) */
     /* Messages written by display_draw_combat_message() */
     
@@ -122,162 +225,190 @@ void display_draw_combat_message(const char *message) {
     cputsxy(0, 21, line_buf);
 }
 
+/**
+ * Draw frame timing over the separator on line 22: the whole pass, then
+ * network, render and input, each in percent of a frame
+ */
+void display_draw_frame_stats(const frame_stats_t *stats) {
+    static char line_buf[41];
+    int len;
+    
+    len = snprintf(line_buf, sizeof(line_buf), "F:%u%% N:%u R:%u I:%u ", stats->frame,
+                   stats->section[FRAME_NET], stats->section[FRAME_RENDER], stats->section[FRAME_INPUT]);
+    if (len < 0 || len > 40) len = 40;
+    memset(line_buf + len, '-', 40 - len);
+    line_buf[40] = '\0';
+    cputsxy(0, 22, line_buf);
+}
+
 /* Game Rendering */
-void display_render_game(const player_state_t *local, const player_state_t *others, uint8_t count, int force_refresh) {
-    static uint8_t last_player_x = 255;
-    static uint8_t last_player_y = 255;
-    static uint8_t last_other_positions[MAX_OTHER_PLAYERS * 2];  /* x,y pairs */
-    static uint8_t last_other_count = 255;
-    static int world_rendered = 0; /* Moved declaration to top */
-    static int positions_initialized = 0;
-    uint8_t x, y, i;
-    char entity_char;
+
+/* Camera origin in world coordinates (top-left cell of the play area) */
+static uint16_t cam_x = 0;
+static uint16_t cam_y = 0;
+
+/**
+ * Centre the camera on (x, y), clamped so it never shows past the world edge.
+ * Matches the server's viewport rule so the area of interest lines up.
+ */
+static void update_camera(uint16_t x, uint16_t y) {
+    uint16_t world_w = state_get_world_width();
+    uint16_t world_h = state_get_world_height();
     
-    /* Initialize position tracking to invalid values on first call */
-    if (!positions_initialized) {
-        for (i = 0; i < MAX_OTHER_PLAYERS * 2; i++) {
-            last_other_positions[i] = 255;
-        }
-        positions_initialized = 1;
+    cam_x = 0;
+    if (world_w > DISPLAY_WIDTH && x > DISPLAY_WIDTH / 2) {
+        cam_x = x - DISPLAY_WIDTH / 2;
+        if (cam_x > world_w - DISPLAY_WIDTH) cam_x = world_w - DISPLAY_WIDTH;
     }
-    
-    if (!local || local->x >= 255 || local->y >= 255) {
-        return;
+    cam_y = 0;
+    if (world_h > DISPLAY_HEIGHT && y > DISPLAY_HEIGHT / 2) {
+        cam_y = y - DISPLAY_HEIGHT / 2;
+        if (cam_y > world_h - DISPLAY_HEIGHT) cam_y = world_h - DISPLAY_HEIGHT;
     }
+}
+
+/**
+ * Convert world coordinates to screen coordinates.
+ * Returns 0 if the cell is outside the play area.
+ */
+static uint8_t world_to_screen(uint16_t x, uint16_t y, uint8_t *sx, uint8_t *sy) {
+    if (x < cam_x || y < cam_y) return 0;
+    if (x - cam_x >= DISPLAY_WIDTH || y - cam_y >= DISPLAY_HEIGHT) return 0;
+    *sx = (uint8_t)(x - cam_x);
+    *sy = (uint8_t)(y - cam_y);
+    return 1;
+}
+
+static char entity_glyph(const entity_t *e) {
+    if (e->kind & ENTITY_PLAYER) return CHAR_WALL;
+    if (e->kind & ENTITY_HUNTER) return CHAR_HUNTER;
+    return CHAR_ENEMY;
+}
+
+/**
+ * Slot holding eid, or the empty slot where it belongs
+ */
+static drawn_t *drawn_find(drawn_t *table, uint16_t eid) {
+    uint8_t slot = (uint8_t)eid & (DRAWN_SLOTS - 1);
     
-    /* Full redraw on first render or when player count changes or refresh requested */
+    while (table[slot].eid != 0 && table[slot].eid != eid) {
+        slot = (slot + 1) & (DRAWN_SLOTS - 1);
+    }
+    return &table[slot];
+}
+
+static void mark_cell(uint16_t cell) {
+    if (cell < DISPLAY_WIDTH * DISPLAY_HEIGHT) {
+        row_dirty[cell / DISPLAY_WIDTH] = 1;
+    }
+}
+
+/**
+ * Mark the rows that differ between the hidden page and this frame, and
+ * record the frame as what that page will show
+ */
+static void mark_dirty_rows(const entity_t *others, uint8_t count, uint16_t player_cell) {
+    uint8_t page = dbuf_hidden();
+    drawn_t *table = drawn[page];
+    drawn_t *d;
+    uint8_t all;
+    uint8_t i;
+    uint8_t sx, sy;
+    uint16_t cell;
+    char glyph;
     
-    if (force_refresh) {
-        world_rendered = 0;
+    all = !drawn_valid[page] || drawn_cam_x[page] != cam_x || drawn_cam_y[page] != cam_y;
+    for (i = 0; i < count && !all; i++) {
+        all = others[i].eid == 0;
+    }
+    memset(row_dirty, all, sizeof(row_dirty));
+    if (player_cell != drawn_player[page]) {
+        mark_cell(drawn_player[page]);
+        mark_cell(player_cell);
     }
     
-    /* Only do full redraw on first render or explicit refresh */
-    if (!world_rendered) {
-        clrscr();
-        /* Draw world line by line - this fills the play area */
-        for (y = 0; y < DISPLAY_HEIGHT; y++) {
-            gotoxy(0, y);
-            for (x = 0; x < DISPLAY_WIDTH; x++) {
-                printf("%c", CHAR_EMPTY);
-            }
+    memcpy(drawn_prev, table, sizeof(drawn_prev));
+    memset(table, 0, sizeof(drawn[0]));
+    for (i = 0; i < count; i++) {
+        if (others[i].eid == 0) {
+            continue;
         }
-        
-        /* Draw other entities */
-        for (i = 0; i < count; i++) {
-            if (others[i].x < DISPLAY_WIDTH && others[i].y < DISPLAY_HEIGHT) {
-                gotoxy(others[i].x, others[i].y);
-                if (strcmp(others[i].type, "player") == 0) {
-                    entity_char = CHAR_WALL;
-                } else if (others[i].isHunter) {
-                    entity_char = CHAR_HUNTER;
-                } else {
-                    entity_char = CHAR_ENEMY;
-                }
-                printf("%c", entity_char);
-            }
+        cell = NO_CELL;
+        glyph = entity_glyph(&others[i]);
+        if (world_to_screen(others[i].x, others[i].y, &sx, &sy)) {
+            cell = sy * DISPLAY_WIDTH + sx;
+            d = drawn_find(table, others[i].eid);
+            d->eid = others[i].eid;
+            d->cell = cell;
+            d->glyph = glyph;
         }
         
-        /* Draw local player */
-        if (local->x < DISPLAY_WIDTH && local->y < DISPLAY_HEIGHT) {
-            gotoxy(local->x, local->y);
-            printf("%c", CHAR_PLAYER);
-        }
-        
-        last_player_x = local->x;
-        last_player_y = local->y;
-        last_other_count = count;
-        world_rendered = 1;
-        
-        /* Initialize tracked positions */
-        for (i = 0; i < count && i < MAX_OTHER_PLAYERS; i++) {
-            last_other_positions[i * 2] = others[i].x;
-            last_other_positions[i * 2 + 1] = others[i].y;
-        }
-        /* Mark remaining slots as invalid */
-        for (i = count; i < MAX_OTHER_PLAYERS; i++) {
-            last_other_positions[i * 2] = 255;
-            last_other_positions[i * 2 + 1] = 255;
-        }
-        
-    } else {
-        /* INCREMENTAL UPDATE - no full redraw */
-        
-        /* If entity count decreased, erase old positions for removed entities */
-        if (count < last_other_count) {
-            for (i = count; i < last_other_count && i < MAX_OTHER_PLAYERS; i++) {
-                uint8_t old_x = last_other_positions[i * 2];
-                uint8_t old_y = last_other_positions[i * 2 + 1];
-                if (old_x < DISPLAY_WIDTH && old_y < DISPLAY_HEIGHT) {
-                    gotoxy(old_x, old_y);
-                    printf("%c", CHAR_EMPTY);
-                }
-                last_other_positions[i * 2] = 255;
-                last_other_positions[i * 2 + 1] = 255;
+        d = drawn_find(drawn_prev, others[i].eid);
+        if (d->eid == 0) {
+            mark_cell(cell);           /* Appeared */
+        } else if (d->cell != SEEN_CELL) {
+            if (d->cell != cell || d->glyph != glyph) {
+                mark_cell(d->cell);    /* Moved or changed */
+                mark_cell(cell);
             }
+            d->cell = SEEN_CELL;
         }
-        last_other_count = count;
-        
-        /* Update player position if changed */
-        if (local->x != last_player_x || local->y != last_player_y) {
-            /* Erase old player position */
-            gotoxy(last_player_x, last_player_y);
-            printf("%c", CHAR_EMPTY);
-            
-            /* Draw new player position */
-            gotoxy(local->x, local->y);
-            printf("%c", CHAR_PLAYER);
-            
-            last_player_x = local->x;
-            last_player_y = local->y;
+    }
+    for (i = 0; i < DRAWN_SLOTS; i++) {
+        if (drawn_prev[i].eid != 0) {
+            mark_cell(drawn_prev[i].cell);  /* Left: SEEN_CELL and NO_CELL are ignored */
         }
-        
-        /* Update other entities incrementally */
-        for (i = 0; i < count && i < MAX_OTHER_PLAYERS; i++) {
-            uint8_t old_x = last_other_positions[i * 2];
-            uint8_t old_y = last_other_positions[i * 2 + 1];
-            uint8_t new_x_other = others[i].x;
-            uint8_t new_y_other = others[i].y;
-            
-            /* If position changed, update it */
-            if (old_x != new_x_other || old_y != new_y_other) {
-                /* Erase old position (if valid) */
-                if (old_x < DISPLAY_WIDTH && old_y < DISPLAY_HEIGHT) {
-                    gotoxy(old_x, old_y);
-                    printf("%c", CHAR_EMPTY);
-                }
-                
-                /* Draw new position */
-                if (new_x_other < DISPLAY_WIDTH && new_y_other < DISPLAY_HEIGHT) {
-                    gotoxy(new_x_other, new_y_other);
-                    if (strcmp(others[i].type, "player") == 0) {
-                        entity_char = CHAR_WALL;
-                    } else if (others[i].isHunter) {
-                        entity_char = CHAR_HUNTER;
-                    } else {
-                        entity_char = CHAR_ENEMY;
-                    }
-                    printf("%c", entity_char);
-                }
-                
-                /* Update tracked position */
-                last_other_positions[i * 2] = new_x_other;
-                last_other_positions[i * 2 + 1] = new_y_other;
-            }
+    }
+    
+    drawn_player[page] = player_cell;
+    drawn_cam_x[page] = cam_x;
+    drawn_cam_y[page] = cam_y;
+    drawn_valid[page] = 1;
+}
+
+void display_render_game(const player_state_t *local, const entity_t *others, uint8_t count, int force_refresh) {
+    uint8_t i;
+    uint8_t sx, sy;
+    
+    if (!local) {
+        return;
+    }
+    
+    /* Scroll with the local player */
+    update_camera(local->x, local->y);
+    if (!world_to_screen(local->x, local->y, &sx, &sy)) {
+        return;
+    }
+    
+    if (force_refresh) {
+        clear_screen();
+    }
+    
+    /* Compose the frame: empty floor, other entities, then the player on top */
+    mark_dirty_rows(others, count, sy * DISPLAY_WIDTH + sx);
+    memset(screen_back, CHAR_EMPTY, sizeof(screen_back));
+    screen_back[sy * DISPLAY_WIDTH + sx] = CHAR_PLAYER;
+    for (i = 0; i < count; i++) {
+        if (world_to_screen(others[i].x, others[i].y, &sx, &sy) &&
+            screen_back[sy * DISPLAY_WIDTH + sx] != CHAR_PLAYER) {
+            screen_back[sy * DISPLAY_WIDTH + sx] = entity_glyph(&others[i]);
         }
     }
+    
+    flush_screen();
 }
 
 /* Dialogs and Prompts */
 
 void display_show_join_prompt(void) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 5);
     printf("Enter player name:\n");
     gotoxy(0, 7);
 }
 
 void display_show_rejoining(const char *name) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 8);
     printf("  Rejoining as: %s\n", name);
     gotoxy(0, 10);
@@ -285,7 +416,7 @@ void display_show_rejoining(const char *name) {
 }
 
 void display_show_quit_confirmation(void) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 8);
     printf("  Are you sure you want to quit?\n");
     gotoxy(0, 10);
@@ -295,7 +426,7 @@ void display_show_quit_confirmation(void) {
 }
 
 void display_show_connection_lost(void) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 8);
     printf("  CONNECTION LOST\n");
     gotoxy(0, 10);
@@ -307,7 +438,7 @@ void display_show_connection_lost(void) {
 }
 
 void display_show_death_message(void) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 8);
     printf("  *** YOU WERE KILLED! ***\n");
     gotoxy(0, 10);
@@ -317,7 +448,7 @@ void display_show_death_message(void) {
 }
 
 void display_show_error(const char *error) {
-    clrscr();
+    clear_screen();
     gotoxy(0, 10);
     printf("ERROR: %s\n", error);
 }
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #endif
 #include "state.h"
+#include "frame.h"
 
 #include "constants.h"
 
@@ -32,9 +33,10 @@ void display_draw_status_bar(const char *player_name, uint8_t player_count,
                              const char *connection_status, uint16_t world_ticks);
 void display_draw_command_help(void);
 void display_draw_combat_message(const char *message);
+void display_draw_frame_stats(const frame_stats_t *stats);
 
 /* Game Rendering */
-void display_render_game(const player_state_t *local, const player_state_t *others, uint8_t count, int force_refresh);
+void display_render_game(const player_state_t *local, const entity_t *others, uint8_t count, int force_refresh);
 
 /* Dialogs and Prompts */
 void display_show_join_prompt(void);
@@ -0,0 +1,34 @@
+/**
+ * KillZone Double Buffer
+ *
+ * Page-flipped play area. Frames are drawn (through screen_put_span) into
+ * the hidden page and shown at the next vertical blank, so a half-drawn
+ * frame is never on screen. Page 0 is the screen conio draws on; the status
+ * rows below the play area always come from it.
+ *
+ * Targets without a second page (DBUF_PAGES 1) draw in place and the
+ * functions do nothing.
+ */
+
+#ifndef KILLZONE_DOUBLE_BUFFER_H
+#define KILLZONE_DOUBLE_BUFFER_H
+
+#ifdef _CMOC_VERSION_
+#include <cmoc.h>
+#else
+#include <stdint.h>
+#endif
+
+#ifdef __ATARI__
+#define DBUF_PAGES 2
+#else
+#define DBUF_PAGES 1
+#endif
+
+void dbuf_init(void);       /* Set up the pages; page 0 is shown */
+void dbuf_close(void);      /* Give the whole screen back to conio */
+void dbuf_reset(void);      /* Show page 0 again, after conio has drawn over it */
+uint8_t dbuf_hidden(void);  /* Page screen_put_span draws into */
+void dbuf_flip(void);       /* Wait for vertical blank and show the hidden page */
+
+#endif /* KILLZONE_DOUBLE_BUFFER_H */
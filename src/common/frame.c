@@ -0,0 +1,128 @@
+/**
+ * KillZone Frame Scheduler Implementation
+ */
+
+#include "frame.h"
+#include "timer.h"
+#ifdef __ATARI__
+#include <atari.h>
+#endif
+
+#ifdef __ATARI__
+#define VBI_LINE 124   /* VCOUNT when vertical blank starts, PAL and NTSC */
+#define VBI_SETTLE 2   /* Lines the OS may take to bump RTCLOK after that */
+static uint8_t frame_lines = 131; /* VCOUNT values per frame: 131 NTSC, 156 PAL */
+
+/* Jiffies times frame_lines, plus lines since the jiffy began. The value
+ * wraps, but differences between two readings come out right. */
+static uint16_t lines_now(void) {
+    uint8_t lo;
+    uint8_t hi;
+    uint8_t v;
+
+    do {
+        while (ANTIC.vcount >= VBI_LINE && ANTIC.vcount < VBI_LINE + VBI_SETTLE) {
+            /* RTCLOK may not have moved on yet */
+        }
+        lo = OS.rtclok[2];
+        hi = OS.rtclok[1];
+        v = ANTIC.vcount;
+    } while (lo != OS.rtclok[2]);
+
+    v = v >= VBI_LINE ? v - VBI_LINE : v + frame_lines - VBI_LINE;
+    return (((uint16_t)hi << 8) | lo) * frame_lines + v;
+}
+#elif defined(__linux__)
+#define frame_lines LINUX_LINES
+#define lines_now() linux_lines()
+#else
+/* No raster counter to read: time is only known to the jiffy */
+#define frame_lines 1
+#define lines_now() timer_now()
+#endif
+
+static uint16_t frame_jiffy;   /* timer_now() when this frame began */
+static uint16_t frame_start;   /* lines_now() then */
+static uint16_t mark;          /* End of the last charge */
+static uint16_t sums[FRAME_SECTIONS + 1]; /* Last entry: whole frames */
+static uint8_t counted = 0;
+static frame_stats_t stats;
+static uint8_t stats_new = 0;
+
+/* Add a sample to a section's sum. A sample is capped at SAMPLE_FRAMES
+ * frames, so a long stall (a reconnect) shows up as an overrun without
+ * wrapping the sum: 16 capped samples of 156 lines still fit in 16 bits. */
+#define SAMPLE_FRAMES 3
+static void add_sample(uint8_t section, uint16_t lines) {
+    uint16_t cap = (uint16_t)frame_lines * SAMPLE_FRAMES;
+
+    sums[section] += lines > cap ? cap : lines;
+}
+
+static uint16_t to_percent(uint16_t lines) {
+    return (uint16_t)((unsigned long)lines * 100 / frame_lines);
+}
+
+void frame_init(void) {
+#ifdef __ATARI__
+    frame_lines = get_tv() == AT_PAL ? 156 : 131;
+#endif
+    frame_jiffy = timer_now();
+    frame_start = mark = lines_now();
+}
+
+uint8_t frame_begin(void) {
+    uint16_t busy = lines_now() - frame_start;
+    uint16_t jiffy;
+    uint8_t i;
+
+    while ((jiffy = timer_now()) == frame_jiffy) {
+        timer_idle(); /* Wait for the next vertical blank */
+    }
+
+    add_sample(FRAME_SECTIONS, busy);
+    if (++counted == FRAME_STATS_FRAMES) {
+        stats.frame = to_percent(sums[FRAME_SECTIONS] / FRAME_STATS_FRAMES);
+        for (i = 0; i < FRAME_SECTIONS; i++) {
+            stats.section[i] = to_percent(sums[i] / FRAME_STATS_FRAMES);
+        }
+        for (i = 0; i <= FRAME_SECTIONS; i++) {
+            sums[i] = 0;
+        }
+        counted = 0;
+        stats_new = 1;
+    }
+
+    i = (uint8_t)(jiffy - frame_jiffy);
+    frame_jiffy = jiffy;
+    frame_start = mark = lines_now();
+    return i;
+}
+
+void frame_charge(uint8_t section) {
+    uint16_t now = lines_now();
+
+    add_sample(section, now - mark);
+    mark = now;
+}
+
+uint8_t frame_has_time(uint8_t pct) {
+    uint16_t used = lines_now() - frame_start;
+
+    if (used >= (uint16_t)frame_lines * SAMPLE_FRAMES) return 0;
+    return used * 100 < (uint16_t)pct * frame_lines;
+}
+
+uint8_t frame_every(uint16_t *last, uint8_t period) {
+    if ((uint16_t)(frame_jiffy - *last) < period) return 0;
+    *last = frame_jiffy;
+    return 1;
+}
+
+uint8_t frame_stats(frame_stats_t *out) {
+    uint8_t fresh = stats_new;
+
+    *out = stats;
+    stats_new = 0;
+    return fresh;
+}
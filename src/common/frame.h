@@ -0,0 +1,55 @@
+/**
+ * KillZone Frame Scheduler
+ *
+ * Paces the main loop to the jiffy clock (one pass per video frame) and
+ * times the work in each pass, so periodic jobs run on the clock instead of
+ * on loop counts and can be put off when a frame is already full.
+ *
+ * Time within a frame is measured in "lines": ANTIC's VCOUNT on the Atari
+ * (two scanlines each), hundredths of a jiffy on the Linux host build, the
+ * jiffy itself elsewhere.
+ */
+
+#ifndef KILLZONE_FRAME_H
+#define KILLZONE_FRAME_H
+
+#ifdef _CMOC_VERSION_
+#include <cmoc.h>
+#else
+#include <stdint.h>
+#endif
+
+/* Work the profiler charges time to */
+#define FRAME_NET     0
+#define FRAME_RENDER  1
+#define FRAME_INPUT   2
+#define FRAME_SECTIONS 3
+
+#define FRAME_STATS_FRAMES 16  /* Frames averaged into each set of stats (a power of two) */
+
+/* Averages over the last FRAME_STATS_FRAMES frames, in percent of a frame */
+typedef struct {
+    uint16_t frame;                    /* Whole pass, 100 = on time */
+    uint16_t section[FRAME_SECTIONS];
+} frame_stats_t;
+
+void frame_init(void);
+
+/* Wait for the next jiffy unless one has passed since the last call, and
+ * start timing a new frame. Returns the jiffies since the last frame began
+ * (more than 1 means that frame overran). */
+uint8_t frame_begin(void);
+
+/* Charge the time since the last charge (or frame_begin) to a section */
+void frame_charge(uint8_t section);
+
+/* 1 if less than pct percent of this frame has been used so far */
+uint8_t frame_has_time(uint8_t pct);
+
+/* 1 once period jiffies have passed since it last returned 1 for *last */
+uint8_t frame_every(uint16_t *last, uint8_t period);
+
+/* Latest averages; returns 1 when they have changed since the last call */
+uint8_t frame_stats(frame_stats_t *out);
+
+#endif /* KILLZONE_FRAME_H */
@@ -20,7 +20,8 @@ typedef enum {
     CMD_QUIT,
     CMD_YES,
     CMD_NO,
-    CMD_ATTACK
+    CMD_ATTACK,
+    CMD_STATS      /* Toggle the frame timing overlay */
 } input_cmd_t;
 
 /**
@@ -30,14 +31,26 @@ void input_init(void);
 
 /**
  * Check for input and return command
- * Non-blocking
+ * Non-blocking. Keypresses are queued, so a caller that wants a whole
+ * burst calls it until it returns CMD_NONE.
  */
 input_cmd_t input_check(void);
 
+/**
+ * Queue keypresses in the background so none are lost while a frame is
+ * busy (on by default). Turn it off around line input through stdio.
+ */
+void input_queue_keys(uint8_t on);
+
 /**
  * Wait for a specific key press (blocking)
  * Returns the character pressed
  */
 char input_wait_key(void);
 
+/**
+ * Shut down input system
+ */
+void input_close(void);
+
 #endif /* INPUT_H */
@@ -23,6 +23,8 @@ static char path_buf[256];
 static char body_buf[256];
 static char value_buf[256]; /* Buffer for JSON values */
 static char query_buf[64];  /* Buffer for JSON keys/paths */
+static uint8_t view_width = 0;  /* Declared viewport, 0 = whole world */
+static uint8_t view_height = 0;
 
 static void build_device_spec(const char *path) {
     snprintf(device_spec, DEVICE_SPEC_SIZE, "N:HTTP://%s:%d%s", SERVER_HOST, SERVER_PORT, path);
@@ -147,8 +149,8 @@ uint8_t kz_network_join_player(const char *name, player_state_t *player) {
         strncpy(player->name, player->id, sizeof(player->name));
     }
     
-    if (query_int("/x", &val)) player->x = (uint8_t)val;
-    if (query_int("/y", &val)) player->y = (uint8_t)val;
+    if (query_int("/x", &val)) player->x = (uint16_t)val;
+    if (query_int("/y", &val)) player->y = (uint16_t)val;
     if (query_int("/health", &val)) player->health = (uint8_t)val;
     else player->health = 100;
     
@@ -163,34 +165,39 @@ uint8_t kz_network_join_player(const char *name, player_state_t *player) {
     return 1;
 }
 
-/* Helper to parse a single player from the array */
-static void parse_single_player(int index, player_state_t *player) {
+/* Helper to parse a single entity from the array; its name is not fetched */
+static void parse_single_player(int index, entity_t *entity) {
+    static char type_buf[8];
     uint32_t val;
     uint8_t bval;
     
+    entity->eid = 0; /* JSON ids are strings: matched by index */
+    
     snprintf(query_buf, sizeof(query_buf), "/players/%d/x", index);
-    if (query_int(query_buf, &val)) player->x = (uint8_t)val;
+    if (query_int(query_buf, &val)) entity->x = (uint16_t)val;
     
     snprintf(query_buf, sizeof(query_buf), "/players/%d/y", index);
-    if (query_int(query_buf, &val)) player->y = (uint8_t)val;
+    if (query_int(query_buf, &val)) entity->y = (uint16_t)val;
     
+    entity->kind = 0;
     snprintf(query_buf, sizeof(query_buf), "/players/%d/type", index);
-    if (!query_string(query_buf, player->type, sizeof(player->type))) {
-        strcpy(player->type, "mob");
+    if (query_string(query_buf, type_buf, sizeof(type_buf)) && strcmp(type_buf, "player") == 0) {
+        entity->kind = ENTITY_PLAYER;
     }
     
     snprintf(query_buf, sizeof(query_buf), "/players/%d/isHunter", index);
-    if (query_bool(query_buf, &bval)) {
-        player->isHunter = bval;
-    } else {
-        player->isHunter = 0;
+    if (query_bool(query_buf, &bval) && bval) {
+        entity->kind |= ENTITY_HUNTER;
     }
-    
-    player->health = 100;
-    strcpy(player->status, "alive");
 }
 
-static player_state_t other_players[MAX_OTHER_PLAYERS];
+uint8_t kz_network_set_viewport(uint8_t width, uint8_t height) {
+    /* HTTP is stateless - the viewport rides along on each state request */
+    view_width = width;
+    view_height = height;
+    return 1;
+}
+
 static char id_buf[32];
 
 uint8_t kz_network_get_world_state(void) {
@@ -198,11 +205,18 @@ uint8_t kz_network_get_world_state(void) {
     uint32_t width, height, ticks;
     uint8_t count = 0;
     const player_state_t *local = state_get_local_player();
+    entity_t *others = state_other_players_table();
     int i;
     
     if (current_status != NET_CONNECTED) return 0;
     
-    build_device_spec("/api/world/state");
+    if (view_width && local && local->id[0] != '\0') {
+        snprintf(path_buf, sizeof(path_buf), "/api/world/state?playerId=%s&viewWidth=%d&viewHeight=%d",
+                 local->id, view_width, view_height);
+        build_device_spec(path_buf);
+    } else {
+        build_device_spec("/api/world/state");
+    }
     err = network_open(device_spec, OPEN_MODE_HTTP_GET, OPEN_TRANS_NONE);
     if (err != FN_ERR_OK) return 0;
     err = network_json_parse(device_spec);
@@ -213,7 +227,7 @@ uint8_t kz_network_get_world_state(void) {
     
     /* Global properties */
     if (query_int("/width", &width) && query_int("/height", &height)) {
-        state_set_world_dimensions((uint8_t)width, (uint8_t)height);
+        state_set_world_dimensions((uint16_t)width, (uint16_t)height);
     }
     
     if (query_int("/ticks", &ticks)) {
@@ -233,12 +247,11 @@ uint8_t kz_network_get_world_state(void) {
             continue;
         }
         
-        strncpy(other_players[count].id, id_buf, sizeof(other_players[count].id));
-        parse_single_player(i, &other_players[count]);
+        parse_single_player(i, &others[count]);
         count++;
     }
     
-    state_set_other_players(other_players, count);
+    state_set_other_players(count);
     
     network_close(device_spec);
     return 1;
@@ -265,8 +278,8 @@ uint8_t kz_network_get_player_status(const char *player_id, player_state_t *play
     /* Extract fields */
     strncpy(player->id, player_id, sizeof(player->id));
     
-    if (query_int("/x", &val)) player->x = (uint8_t)val;
-    if (query_int("/y", &val)) player->y = (uint8_t)val;
+    if (query_int("/x", &val)) player->x = (uint16_t)val;
+    if (query_int("/y", &val)) player->y = (uint16_t)val;
     if (query_int("/health", &val)) player->health = (uint8_t)val;
     
     query_string("/status", player->status, sizeof(player->status));
@@ -316,8 +329,8 @@ uint8_t kz_network_move_player(const char *player_id, const char *direction, mov
     }
     
     /* Parse result */
-    if (query_int("/x", &val)) result->x = (uint8_t)val;
-    if (query_int("/y", &val)) result->y = (uint8_t)val;
+    if (query_int("/x", &val)) result->x = (uint16_t)val;
+    if (query_int("/y", &val)) result->y = (uint16_t)val;
     
     if (query_bool("/collision", &bval)) result->collision = bval;
     else result->collision = 0;
@@ -366,4 +379,19 @@ uint8_t kz_network_leave_player(const char *player_id) {
     
     network_close(device_spec);
     return 1;
-}
\ No newline at end of file
+}
+
+uint8_t kz_network_pump(void) {
+    /* HTTP requests complete inside the call that makes them */
+    return 0;
+}
+
+uint8_t kz_network_flush_moves(void) {
+    /* Each HTTP move has already been posted */
+    return 1;
+}
+
+uint16_t kz_network_server_tick(void) {
+    /* No clock sync over HTTP: the last reported tick is the best we have */
+    return state_get_world_ticks();
+}
@@ -24,8 +24,8 @@ typedef enum {
 
 /* Move result structure */
 typedef struct {
-    uint8_t x;
-    uint8_t y;
+    uint16_t x;
+    uint16_t y;
     uint8_t collision;
     char messages[4][41];
     uint8_t message_count;
@@ -44,15 +44,36 @@ uint8_t kz_network_health_check(void);
 /* Returns 1 if success, 0 if failed. Populates player struct. */
 uint8_t kz_network_join_player(const char *name, player_state_t *player);
 
-/* Returns 1 if success, 0 if failed. Updates global state directly. */
+/* Returns 1 if success, 0 if failed. Updates global state directly.
+ * On a non-blocking link this only makes sure a request is in flight. */
 uint8_t kz_network_get_world_state(void);
 
+/* Take in whatever replies have arrived without waiting for more, and send
+ * the next state request once the last one is answered. Call every frame.
+ * Returns 0 if the link only works blocking (HTTP, older servers). */
+uint8_t kz_network_pump(void);
+
+/* Declare the client viewport so the server only sends nearby entities.
+ * Returns 1 if success, 0 if failed. */
+uint8_t kz_network_set_viewport(uint8_t width, uint8_t height);
+
+/* Best estimate of the server's current tick, advanced between pongs
+ * when the server reports a fixed tick rate. */
+uint16_t kz_network_server_tick(void);
+
 /* Returns 1 if success, 0 if failed. Populates player struct. */
 uint8_t kz_network_get_player_status(const char *player_id, player_state_t *player);
 
-/* Returns 1 if success, 0 if failed. Populates result struct. */
+/* Returns 1 if success, 0 if failed. Populates result struct.
+ * Over TCP with protocol 7 the result is a prediction returned without waiting;
+ * the server's answer corrects the local player on a later poll. */
 uint8_t kz_network_move_player(const char *player_id, const char *direction, move_result_t *result);
 
+/* Send the moves queued since the last call as one packet (protocol 8 over
+ * TCP; elsewhere each move has already gone out). Call after a burst of
+ * kz_network_move_player calls. Returns 0 if the write failed. */
+uint8_t kz_network_flush_moves(void);
+
 /* Returns 1 if success, 0 if failed. */
 uint8_t kz_network_leave_player(const char *player_id);
 
@@ -0,0 +1,22 @@
+/**
+ * KillZone Screen Backend
+ *
+ * Writes text straight into display memory, bypassing conio's cursor
+ * handling and stdio. Each target supplies its own implementation
+ * (src/<target>/screen.*); the display module uses it for the play area.
+ */
+
+#ifndef KILLZONE_SCREEN_H
+#define KILLZONE_SCREEN_H
+
+#ifdef _CMOC_VERSION_
+#include <cmoc.h>
+#else
+#include <stdint.h>
+#endif
+
+/* Draw len characters of s at column x, row y. The span must fit on the row;
+ * the cursor position is left unchanged. */
+void screen_put_span(uint8_t x, uint8_t y, const char *s, uint8_t len);
+
+#endif /* KILLZONE_SCREEN_H */
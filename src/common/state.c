@@ -5,6 +5,7 @@
  */
 
 #include "state.h"
+#include "timer.h"
 #ifdef _CMOC_VERSION_
 #include <cmoc.h>
 #include <coco.h>
@@ -15,15 +16,45 @@
 /* Global state */
 static client_state_t current_state = STATE_INIT;
 static player_state_t local_player;
-static player_state_t other_players[MAX_OTHER_PLAYERS];
+static entity_t other_players[MAX_OTHER_PLAYERS];
 static uint8_t other_player_count = 0;
-static uint8_t world_width = 40;
-static uint8_t world_height = 20;
+static uint16_t world_width = 40;
+static uint16_t world_height = 20;
 static uint16_t world_ticks = 0;
 char error_message[128];
 static int is_rejoining = 0;
 static int is_connected = 1;  /* Track connection state (1=connected, 0=disconnected) */
 
+/* Snapshot interpolation: other_players holds the positions being drawn,
+ * and the last two snapshots are kept in from_* and to_* so each entity
+ * walks from one to the other over the time that separated them (the
+ * network layer decodes straight into other_players, so to_* holds a copy
+ * of the newest). Entities with an id are matched through
+ * a small open-addressed table (linear probing, eid 0 = empty) mapping the
+ * previous snapshot's ids to their index. Without ids (servers that do not
+ * grant NUMERIC_IDS) they fall back to matching by index, but only while the
+ * count is unchanged: a death or a leave shifts everything after it, and the
+ * entity now at that index is someone else. */
+#define INTERP_MAX_STEP 4         /* Longer jumps (respawns, reordering) are drawn at once */
+#define INTERP_MAX_SPAN TIMER_HZ  /* Trail the newest snapshot by at most a second */
+#define ID_SLOTS 256              /* Power of two, at least twice MAX_OTHER_PLAYERS */
+#define NO_MATCH 0xFF
+static uint16_t from_x[MAX_OTHER_PLAYERS];
+static uint16_t from_y[MAX_OTHER_PLAYERS];
+static uint8_t from_kind[MAX_OTHER_PLAYERS];
+static uint8_t from_count = 0;
+static uint16_t from_id_key[ID_SLOTS];
+static uint8_t from_id_index[ID_SLOTS];
+static uint8_t from_match[MAX_OTHER_PLAYERS]; /* Index in from_* of each entity, or NO_MATCH */
+static uint16_t to_x[MAX_OTHER_PLAYERS];
+static uint16_t to_y[MAX_OTHER_PLAYERS];
+static uint8_t to_kind[MAX_OTHER_PLAYERS];
+static uint16_t to_eid[MAX_OTHER_PLAYERS];
+static uint16_t snap_ticks = 0;  /* Server tick of the newest snapshot */
+static uint16_t snap_at = 0;     /* Local time it arrived */
+static uint16_t snap_span = 0;   /* Time between the last two, 0 = draw the newest */
+static uint8_t have_snapshot = 0;
+
 /**
  * Initialize state system
  */
@@ -32,6 +63,8 @@ void state_init(void) {
     memset(&local_player, 0, sizeof(local_player));
     memset(other_players, 0, sizeof(other_players));
     other_player_count = 0;
+    from_count = 0;
+    have_snapshot = 0;
     world_width = 40;
     world_height = 20;
     memset(error_message, 0, sizeof(error_message));
@@ -112,7 +145,7 @@ void state_clear_local_player(void) {
 /**
  * Update local player position
  */
-void state_update_local_position(uint8_t x, uint8_t y) {
+void state_update_local_position(uint16_t x, uint16_t y) {
     local_player.x = x;
     local_player.y = y;
 }
@@ -124,25 +157,125 @@ void state_update_local_health(uint8_t health) {
     local_player.health = health;
 }
 
+/* Slot of eid in the previous snapshot's id table, or the empty slot where it would go */
+static uint8_t id_slot(uint16_t eid) {
+    uint8_t slot = (uint8_t)eid & (ID_SLOTS - 1);
+    
+    while (from_id_key[slot] != 0 && from_id_key[slot] != eid) {
+        slot = (slot + 1) & (ID_SLOTS - 1);
+    }
+    return slot;
+}
+
 /**
- * Set other players in world
+ * Table the network layer decodes the next snapshot into
  */
-void state_set_other_players(const player_state_t *players, uint8_t count) {
+entity_t *state_other_players_table(void) {
+    return other_players;
+}
+
+/**
+ * Commit the first count entries of the table as the newest snapshot
+ * (call after state_set_world_ticks for the same snapshot)
+ */
+void state_set_other_players(uint8_t count) {
+    uint16_t now = timer_now();
+    uint8_t i;
+    uint8_t slot;
+    
     if (count > MAX_OTHER_PLAYERS) {
         count = MAX_OTHER_PLAYERS;
     }
     
-    if (players && count > 0) {
-        memcpy(other_players, players, count * sizeof(player_state_t));
+    /* A new server tick starts a new leg from the previous snapshot; polling
+     * again within the same tick only refreshes the destination */
+    if (!have_snapshot || world_ticks != snap_ticks) {
+        memset(from_id_key, 0, sizeof(from_id_key));
+        for (i = 0; i < other_player_count; i++) {
+            from_x[i] = to_x[i];
+            from_y[i] = to_y[i];
+            from_kind[i] = to_kind[i];
+            if (to_eid[i] != 0) {
+                slot = id_slot(to_eid[i]);
+                from_id_key[slot] = to_eid[i];
+                from_id_index[slot] = i;
+            }
+        }
+        from_count = have_snapshot ? other_player_count : 0;
+        snap_span = have_snapshot ? now - snap_at : 0;
+        if (snap_span > INTERP_MAX_SPAN) {
+            snap_span = INTERP_MAX_SPAN;
+        }
+        snap_at = now;
+        snap_ticks = world_ticks;
+        have_snapshot = 1;
     }
     
     other_player_count = count;
+    for (i = 0; i < count; i++) {
+        to_x[i] = other_players[i].x;
+        to_y[i] = other_players[i].y;
+        to_kind[i] = other_players[i].kind;
+        to_eid[i] = other_players[i].eid;
+        if (other_players[i].eid != 0) {
+            slot = id_slot(other_players[i].eid);
+            from_match[i] = from_id_key[slot] != 0 ? from_id_index[slot] : NO_MATCH;
+        } else {
+            from_match[i] = count == from_count ? i : NO_MATCH;
+        }
+    }
+    state_interpolate_others();
+}
+
+/* One coordinate part way along a leg; the halfway point rounds to the far end */
+static uint16_t interp_coord(uint16_t from, uint16_t to, uint16_t elapsed) {
+    if (to >= from) {
+        return from + (uint16_t)(((to - from) * elapsed + snap_span / 2) / snap_span);
+    }
+    return from - (uint16_t)(((from - to) * elapsed + snap_span / 2) / snap_span);
+}
+
+/**
+ * Move the drawn positions of other entities along their current leg.
+ * Call once per frame before rendering.
+ */
+void state_interpolate_others(void) {
+    uint16_t elapsed = timer_now() - snap_at;
+    uint8_t i;
+    uint8_t j;
+    
+    for (i = 0; i < other_player_count; i++) {
+        j = from_match[i];
+        if (elapsed >= snap_span || j == NO_MATCH || from_kind[j] != to_kind[i] ||
+            (from_x[j] > to_x[i] ? from_x[j] - to_x[i] : to_x[i] - from_x[j]) > INTERP_MAX_STEP ||
+            (from_y[j] > to_y[i] ? from_y[j] - to_y[i] : to_y[i] - from_y[j]) > INTERP_MAX_STEP) {
+            other_players[i].x = to_x[i];
+            other_players[i].y = to_y[i];
+        } else {
+            other_players[i].x = interp_coord(from_x[j], to_x[i], elapsed);
+            other_players[i].y = interp_coord(from_y[j], to_y[i], elapsed);
+        }
+    }
+}
+
+/**
+ * Whether an entity of the newest snapshot stands at (x, y), wherever it is drawn
+ */
+uint8_t state_other_at(uint16_t x, uint16_t y) {
+    uint8_t i;
+    
+    for (i = 0; i < other_player_count; i++) {
+        if (to_x[i] == x && to_y[i] == y) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 /**
  * Get other players in world
  */
-const player_state_t *state_get_other_players(uint8_t *count) {
+const entity_t *state_get_other_players(uint8_t *count) {
     if (count) {
         *count = other_player_count;
     }
@@ -155,12 +288,14 @@ const player_state_t *state_get_other_players(uint8_t *count) {
 void state_clear_other_players(void) {
     memset(other_players, 0, sizeof(other_players));
     other_player_count = 0;
+    from_count = 0;
+    have_snapshot = 0;
 }
 
 /**
  * Set world dimensions
  */
-void state_set_world_dimensions(uint8_t width, uint8_t height) {
+void state_set_world_dimensions(uint16_t width, uint16_t height) {
     world_width = width;
     world_height = height;
 }
@@ -168,14 +303,14 @@ void state_set_world_dimensions(uint8_t width, uint8_t height) {
 /**
  * Get world width
  */
-uint8_t state_get_world_width(void) {
+uint16_t state_get_world_width(void) {
     return world_width;
 }
 
 /**
  * Get world height
  */
-uint8_t state_get_world_height(void) {
+uint16_t state_get_world_height(void) {
     return world_height;
 }
 
@@ -229,6 +364,22 @@ const char *state_get_server_version(void) {
     return server_version;
 }
 
+static uint16_t rtt_ms = 0;
+
+/**
+ * Set smoothed round-trip time
+ */
+void state_set_rtt(uint16_t ms) {
+    rtt_ms = ms;
+}
+
+/**
+ * Get smoothed round-trip time (0 = not measured yet)
+ */
+uint16_t state_get_rtt(void) {
+    return rtt_ms;
+}
+
 static char combat_message[41] = "";
 static uint8_t combat_message_frames = 0;
 
@@ -21,23 +21,24 @@
 typedef struct {
     char id[32];
     char name[32];
-    uint8_t x;
-    uint8_t y;
+    uint16_t x;
+    uint16_t y;
     uint8_t health;
     char status[16];
     char type[8];  /* "player" or "mob" */
     int isHunter;  /* 1 if this is a hunter mob, 0 otherwise */
 } player_state_t;
 
-/* World state */
+/* Remote entity: just what a snapshot carries. Names and string ids are not
+ * kept; a screen that needs one asks the server for it. */
+#define ENTITY_PLAYER 0x01  /* kind flags; neither = plain mob */
+#define ENTITY_HUNTER 0x02
 typedef struct {
-    player_state_t local_player;
-    player_state_t other_players[MAX_OTHER_PLAYERS];
-    uint8_t other_player_count;
-    uint8_t world_width;
-    uint8_t world_height;
-    uint16_t world_ticks;
-} world_state_t;
+    uint16_t eid;   /* Snapshot id (NUMERIC_IDS), stable while in view; 0 = none */
+    uint16_t x;
+    uint16_t y;
+    uint8_t kind;
+} entity_t;
 
 /* Client state machine */
 typedef enum {
@@ -69,18 +70,25 @@ void state_set_current(client_state_t new_state);
 void state_set_local_player(const player_state_t *player);
 const player_state_t *state_get_local_player(void);
 void state_clear_local_player(void);
-void state_update_local_position(uint8_t x, uint8_t y);
+void state_update_local_position(uint16_t x, uint16_t y);
 void state_update_local_health(uint8_t health);
 
-/* World state */
-void state_set_other_players(const player_state_t *players, uint8_t count);
-const player_state_t *state_get_other_players(uint8_t *count);
+/* World state: decode a snapshot straight into the table from
+ * state_other_players_table(), then commit its first count entries */
+entity_t *state_other_players_table(void);
+void state_set_other_players(uint8_t count);
+const entity_t *state_get_other_players(uint8_t *count);
 void state_clear_other_players(void);
 
+/* Other entities are drawn part way between the last two snapshots.
+ * Call state_interpolate_others() each frame before rendering. */
+void state_interpolate_others(void);
+uint8_t state_other_at(uint16_t x, uint16_t y); /* Occupied in the newest snapshot */
+
 /* World dimensions */
-void state_set_world_dimensions(uint8_t width, uint8_t height);
-uint8_t state_get_world_width(void);
-uint8_t state_get_world_height(void);
+void state_set_world_dimensions(uint16_t width, uint16_t height);
+uint16_t state_get_world_width(void);
+uint16_t state_get_world_height(void);
 
 /* World ticks */
 void state_set_world_ticks(uint16_t ticks);
@@ -90,6 +98,10 @@ uint16_t state_get_world_ticks(void);
 void state_set_server_version(const char *version);
 const char *state_get_server_version(void);
 
+/* Smoothed round-trip time to the server in ms (0 = not measured) */
+void state_set_rtt(uint16_t ms);
+uint16_t state_get_rtt(void);
+
 /* Combat message (auto-clears after frames) */
 void state_set_combat_message(const char *msg);
 const char *state_get_combat_message(void);
@@ -0,0 +1,41 @@
+/**
+ * KillZone Timer
+ *
+ * Free-running jiffy clock for latency measurement and interpolation.
+ * cc65's clock() reads the OS frame counter (RTCLOK on the Atari) and
+ * CLOCKS_PER_SEC follows the machine's PAL/NTSC refresh rate.
+ * The 16-bit value wraps every ~18 minutes; only differences are meaningful.
+ */
+
+#ifndef KILLZONE_TIMER_H
+#define KILLZONE_TIMER_H
+
+#ifdef _CMOC_VERSION_
+#include <cmoc.h>
+
+/* CMOC has no clock(): read Color BASIC's TIMER, bumped by the 60 Hz IRQ */
+#define timer_now() (*(volatile uint16_t *)0x0112)
+#define TIMER_HZ 60
+#define timer_idle()
+#elif defined(__linux__)
+#include <stdint.h>
+
+/* Host build: clock() is CPU time there, so count 60 Hz jiffies off the
+ * monotonic clock instead (src/linux/timer.c) */
+uint16_t linux_jiffies(void);
+uint16_t linux_lines(void);  /* LINUX_LINES per jiffy, for frame profiling */
+void linux_idle(void);       /* Sleep a little while waiting for a jiffy */
+#define LINUX_LINES 100
+#define timer_now() linux_jiffies()
+#define TIMER_HZ 60
+#define timer_idle() linux_idle()
+#else
+#include <stdint.h>
+#include <time.h>
+
+#define timer_now() ((uint16_t)clock())
+#define TIMER_HZ ((uint16_t)CLOCKS_PER_SEC)
+#define timer_idle()
+#endif
+
+#endif /* KILLZONE_TIMER_H */
@@ -0,0 +1,53 @@
+/**
+ * KillZone Console Shim Implementation - Linux host build
+ */
+
+#include "conio.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+void clrscr(void) {
+    fputs("\033[H\033[2J", stdout);
+}
+
+/* conio counts from 0, the terminal from 1 */
+void gotoxy(unsigned char x, unsigned char y) {
+    printf("\033[%u;%uH", y + 1, x + 1);
+}
+
+void cputc(char c) {
+    putchar(c);
+}
+
+void cputs(const char *s) {
+    fputs(s, stdout);
+}
+
+void cputcxy(unsigned char x, unsigned char y, char c) {
+    gotoxy(x, y);
+    putchar(c);
+}
+
+void cputsxy(unsigned char x, unsigned char y, const char *s) {
+    gotoxy(x, y);
+    fputs(s, stdout);
+}
+
+int kbhit(void) {
+    fd_set fds;
+    struct timeval tv;
+
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+    return select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
+char cgetc(void) {
+    unsigned char c;
+
+    fflush(stdout);
+    return read(STDIN_FILENO, &c, 1) == 1 ? (char)c : 0;
+}
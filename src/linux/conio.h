@@ -0,0 +1,23 @@
+/**
+ * KillZone Console Shim - Linux host build
+ *
+ * The cc65 conio calls the client makes, written as ANSI escape sequences
+ * on stdout. Output is buffered until a newline, a blocking read or the
+ * end of a frame (linux_idle), much as the Atari shows a frame at once.
+ */
+
+#ifndef KILLZONE_LINUX_CONIO_H
+#define KILLZONE_LINUX_CONIO_H
+
+void clrscr(void);
+void gotoxy(unsigned char x, unsigned char y);
+void cputc(char c);
+void cputs(const char *s);
+void cputcxy(unsigned char x, unsigned char y, char c);
+void cputsxy(unsigned char x, unsigned char y, const char *s);
+
+/* Keyboard: stdin, which input.c puts in cbreak mode while playing */
+int kbhit(void);
+char cgetc(void);
+
+#endif /* KILLZONE_LINUX_CONIO_H */
@@ -0,0 +1,30 @@
+/**
+ * KillZone Double Buffer - Linux host build
+ *
+ * One page, drawn in place. Output is held in the stdout buffer until the
+ * frame is shown, so the terminal gets each frame in one write and no
+ * half-drawn frame is seen.
+ */
+
+#include <stdio.h>
+#include "double_buffer.h"
+
+void dbuf_init(void) {
+    fputs("\033[?25l", stdout); /* Hide the cursor */
+}
+
+void dbuf_close(void) {
+    fputs("\033[?25h", stdout);
+    fflush(stdout);
+}
+
+void dbuf_reset(void) {
+}
+
+uint8_t dbuf_hidden(void) {
+    return 0;
+}
+
+void dbuf_flip(void) {
+    fflush(stdout);
+}
@@ -0,0 +1,49 @@
+/**
+ * KillZone FujiNet Network Shim - Linux host build
+ *
+ * The subset of fujinet-lib's network API the client uses, implemented on
+ * BSD sockets (fujinet_network.c) so the client runs natively against a
+ * local zoneserver. Device specs are the FujiNet ones: N:TCP://host:port
+ * and N:UDP://host:port. HTTP and JSON are not implemented and fail with
+ * FN_ERR_IO_ERROR.
+ */
+
+#ifndef FUJINET_NETWORK_H
+#define FUJINET_NETWORK_H
+
+#include <stdint.h>
+
+#define FN_ERR_OK        0x00
+#define FN_ERR_IO_ERROR  0x01
+#define FN_ERR_BAD_CMD   0x02
+#define FN_ERR_OFFLINE   0x03
+#define FN_ERR_WARNING   0x04
+#define FN_ERR_NO_DEVICE 0x05
+#define FN_ERR_UNKNOWN   0xFF
+
+#define OPEN_MODE_READ  0x04
+#define OPEN_MODE_WRITE 0x08
+#define OPEN_MODE_RW    0x0C
+#define OPEN_TRANS_NONE 0x00
+
+uint8_t network_init(void);
+uint8_t network_open(const char *devicespec, uint8_t mode, uint8_t trans);
+uint8_t network_close(const char *devicespec);
+
+/* Waits for len bytes (TCP) or one datagram (UDP). Returns the bytes read,
+ * negative on error or when nothing arrives within the timeout. */
+int16_t network_read(const char *devicespec, uint8_t *buf, uint16_t len);
+
+/* Returns what has already arrived, up to len: 0 if nothing, negative once
+ * the connection has closed */
+int16_t network_read_nb(const char *devicespec, uint8_t *buf, uint16_t len);
+
+uint8_t network_write(const char *devicespec, const uint8_t *buf, uint16_t len);
+
+/* bw: bytes waiting (the next datagram's size for UDP); c: 1 while connected */
+uint8_t network_status(const char *devicespec, uint16_t *bw, uint8_t *c, uint8_t *err);
+
+uint8_t network_json_parse(const char *devicespec);
+int16_t network_json_query(const char *devicespec, const char *query, char *s);
+
+#endif /* FUJINET_NETWORK_H */
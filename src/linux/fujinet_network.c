@@ -0,0 +1,208 @@
+/**
+ * KillZone FujiNet Network Shim Implementation - Linux host build
+ *
+ * Each open device spec gets a socket. TCP sockets run with Nagle off, as
+ * the FujiNet sends each write as it comes; UDP sockets are connected to
+ * the server so reads only see its datagrams.
+ */
+
+#include "fujinet-network.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define CHANNELS 4
+#define SPEC_MAX 64
+#define READ_TIMEOUT_MS 5000  /* A blocking read gives up after this, as the FujiNet does */
+
+typedef struct {
+    char spec[SPEC_MAX];
+    int fd;                   /* -1 when the channel is free */
+    uint8_t udp;
+} channel_t;
+
+static channel_t channels[CHANNELS];
+static uint8_t channels_ready = 0;
+
+static void init_channels(void) {
+    uint8_t i;
+
+    if (channels_ready) return;
+    for (i = 0; i < CHANNELS; i++) {
+        channels[i].fd = -1;
+    }
+    channels_ready = 1;
+}
+
+static channel_t *find_channel(const char *devicespec) {
+    uint8_t i;
+
+    init_channels();
+    for (i = 0; i < CHANNELS; i++) {
+        if (channels[i].fd >= 0 && strcmp(channels[i].spec, devicespec) == 0) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+uint8_t network_init(void) {
+    init_channels();
+    return FN_ERR_OK;
+}
+
+uint8_t network_open(const char *devicespec, uint8_t mode, uint8_t trans) {
+    char host[SPEC_MAX];
+    char port[8];
+    const char *url;
+    struct addrinfo hints;
+    struct addrinfo *addrs;
+    struct addrinfo *a;
+    channel_t *ch;
+    uint8_t udp;
+    uint8_t i;
+    int fd = -1;
+    int one = 1;
+
+    (void)mode;
+    (void)trans;
+    if (strlen(devicespec) >= SPEC_MAX) return FN_ERR_BAD_CMD;
+
+    /* N:TCP://host:port or N:UDP://host:port (any unit, N1: to N8:) */
+    url = strchr(devicespec, ':');
+    if (!url) return FN_ERR_BAD_CMD;
+    url++;
+    if (strncmp(url, "TCP://", 6) == 0) {
+        udp = 0;
+    } else if (strncmp(url, "UDP://", 6) == 0) {
+        udp = 1;
+    } else {
+        return FN_ERR_IO_ERROR; /* HTTP and the rest are not shimmed */
+    }
+    if (sscanf(url + 6, "%63[^:/]:%7[0-9]", host, port) != 2) return FN_ERR_BAD_CMD;
+
+    network_close(devicespec); /* Reopening a spec starts over, as on the FujiNet */
+    ch = NULL;
+    for (i = 0; i < CHANNELS; i++) {
+        if (channels[i].fd < 0) {
+            ch = &channels[i];
+            break;
+        }
+    }
+    if (!ch) return FN_ERR_NO_DEVICE;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &addrs) != 0) return FN_ERR_IO_ERROR;
+    for (a = addrs; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0) return FN_ERR_IO_ERROR;
+
+    if (!udp) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    strcpy(ch->spec, devicespec);
+    ch->fd = fd;
+    ch->udp = udp;
+    return FN_ERR_OK;
+}
+
+uint8_t network_close(const char *devicespec) {
+    channel_t *ch = find_channel(devicespec);
+
+    if (!ch) return FN_ERR_OK;
+    close(ch->fd);
+    ch->fd = -1;
+    return FN_ERR_OK;
+}
+
+int16_t network_read(const char *devicespec, uint8_t *buf, uint16_t len) {
+    channel_t *ch = find_channel(devicespec);
+    struct pollfd pfd;
+    uint16_t got = 0;
+    ssize_t n;
+
+    if (!ch) return -FN_ERR_IO_ERROR;
+    pfd.fd = ch->fd;
+    pfd.events = POLLIN;
+    while (got < len) {
+        if (poll(&pfd, 1, READ_TIMEOUT_MS) <= 0) break;
+        n = recv(ch->fd, buf + got, len - got, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (uint16_t)n;
+        if (ch->udp) break; /* One datagram per read */
+    }
+    return got > 0 ? (int16_t)got : -FN_ERR_IO_ERROR;
+}
+
+int16_t network_read_nb(const char *devicespec, uint8_t *buf, uint16_t len) {
+    channel_t *ch = find_channel(devicespec);
+    ssize_t n;
+
+    if (!ch) return -FN_ERR_IO_ERROR;
+    n = recv(ch->fd, buf, len, MSG_DONTWAIT);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -FN_ERR_IO_ERROR;
+    }
+    if (n == 0 && !ch->udp) return -FN_ERR_IO_ERROR; /* Closed by the server */
+    return (int16_t)n;
+}
+
+uint8_t network_write(const char *devicespec, const uint8_t *buf, uint16_t len) {
+    channel_t *ch = find_channel(devicespec);
+    uint16_t sent = 0;
+    ssize_t n;
+
+    if (!ch) return FN_ERR_IO_ERROR;
+    while (sent < len) {
+        n = send(ch->fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return FN_ERR_IO_ERROR;
+        sent += (uint16_t)n;
+    }
+    return FN_ERR_OK;
+}
+
+uint8_t network_status(const char *devicespec, uint16_t *bw, uint8_t *c, uint8_t *err) {
+    channel_t *ch = find_channel(devicespec);
+    int waiting = 0;
+    uint8_t probe;
+
+    if (!ch) return FN_ERR_IO_ERROR;
+    if (ioctl(ch->fd, FIONREAD, &waiting) < 0) return FN_ERR_IO_ERROR;
+    *bw = waiting > 0xFFFF ? 0xFFFF : (uint16_t)waiting;
+    *c = 1;
+    if (!ch->udp && waiting == 0 && recv(ch->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+        *c = 0; /* Closed by the server */
+    }
+    *err = *c ? 1 : 136; /* The FujiNet's extended status: 1 = OK, 136 = end of file */
+    return FN_ERR_OK;
+}
+
+uint8_t network_json_parse(const char *devicespec) {
+    (void)devicespec;
+    return FN_ERR_IO_ERROR;
+}
+
+int16_t network_json_query(const char *devicespec, const char *query, char *s) {
+    (void)devicespec;
+    (void)query;
+    s[0] = '\0';
+    return -FN_ERR_IO_ERROR;
+}
@@ -0,0 +1,151 @@
+/**
+ * KillZone Input Module Implementation - Linux host build
+ *
+ * The terminal already queues keystrokes, so the key ring is the tty's
+ * own: queueing keys means cbreak mode (no line editing, no echo), and
+ * turning it off gives fgets the normal line discipline back.
+ */
+
+#include "input.h"
+#include "conio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <termios.h>
+
+static struct termios saved_tio;
+static uint8_t have_saved = 0;
+static uint8_t cbreak = 0;
+
+static void set_cbreak(uint8_t on) {
+    struct termios tio;
+
+    if (!isatty(STDIN_FILENO) || on == cbreak) return;
+    if (!have_saved) {
+        if (tcgetattr(STDIN_FILENO, &saved_tio) != 0) return;
+        have_saved = 1;
+    }
+    tio = saved_tio;
+    if (on) {
+        tio.c_lflag &= ~(ICANON | ECHO);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+    cbreak = on;
+}
+
+static void restore_terminal(void) {
+    set_cbreak(0);
+}
+
+/**
+ * Next key typed, -1 when there is none. Cursor keys arrive as ESC [ A..D
+ * and come back as the Atari arrow codes.
+ */
+static int next_key(void) {
+    char c;
+
+    if (!kbhit()) return -1;
+    c = cgetc();
+    if (c != 27 || !kbhit()) return (unsigned char)c;
+    if (cgetc() != '[' || !kbhit()) return 0;
+    switch (cgetc()) {
+        case 'A': return 28;
+        case 'B': return 29;
+        case 'D': return 30;
+        case 'C': return 31;
+        default: return 0;
+    }
+}
+
+/**
+ * Initialize input system
+ */
+void input_init(void) {
+    /* Unbuffered, so fgets leaves the keys after the name for the game */
+    setvbuf(stdin, NULL, _IONBF, 0);
+    atexit(restore_terminal);
+    set_cbreak(1);
+}
+
+void input_queue_keys(uint8_t on) {
+    set_cbreak(on);
+}
+
+void input_close(void) {
+    set_cbreak(0);
+}
+
+/**
+ * Check for input and return command
+ * Non-blocking
+ */
+input_cmd_t input_check(void) {
+    int c;
+
+    /* Keys that mean nothing here are skipped, so a stray one does not end a burst */
+    while ((c = next_key()) >= 0) {
+        switch (c) {
+            case 'w':
+            case 'W':
+            case 'k':  /* vi-style up */
+            case 28:   /* Up arrow */
+                return CMD_UP;
+
+            case 's':
+            case 'S':
+            case 'j':  /* vi-style down */
+            case 29:   /* Down arrow */
+                return CMD_DOWN;
+
+            case 'a':
+            case 'A':
+            case 'h':  /* vi-style left */
+            case 30:   /* Left arrow */
+                return CMD_LEFT;
+
+            case 'd':
+            case 'D':
+            case 'l':  /* vi-style right */
+            case 31:   /* Right arrow */
+                return CMD_RIGHT;
+
+            case 'r':
+            case 'R':
+                return CMD_REFRESH;
+
+            case 'q':
+            case 'Q':
+                return CMD_QUIT;
+
+            case 'y':
+            case 'Y':
+                return CMD_YES;
+
+            case 'n':
+            case 'N':
+                return CMD_NO;
+
+            case ' ':
+            case 'f':
+            case 'F':
+                return CMD_ATTACK;
+
+            case 'p':
+            case 'P':
+                return CMD_STATS;
+
+            default:
+                break;
+        }
+    }
+    return CMD_NONE;
+}
+
+/**
+ * Wait for a specific key press (blocking)
+ */
+char input_wait_key(void) {
+    return cgetc();
+}
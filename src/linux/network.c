@@ -0,0 +1,9 @@
+/**
+ * KillZone Network Module - Linux host build
+ *
+ * The Atari client as it is, running on the sockets shim in
+ * fujinet_network.c, so its decoders, move prediction and pump can be
+ * profiled and tested natively against a local zoneserver.
+ */
+
+#include "../atari/network.c"
@@ -0,0 +1,21 @@
+/**
+ * KillZone PROCEED Interrupt - Linux host build
+ *
+ * There is no PROCEED line on a socket. proceed_trip always reads as set,
+ * so the network pump reads on every frame.
+ */
+
+#include "../atari/proceed.h"
+
+volatile uint8_t proceed_trip = 1;
+
+void proceed_init(void) {
+    proceed_trip = 1;
+}
+
+void proceed_done(void) {
+}
+
+void proceed_ack(void) {
+    proceed_trip = 1;
+}
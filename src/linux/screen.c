@@ -0,0 +1,15 @@
+/**
+ * KillZone Screen Backend - Linux host build
+ *
+ * Spans go to the terminal as one cursor move and one write, so the play
+ * area costs what the display module asks for and no more.
+ */
+
+#include <stdio.h>
+#include "conio.h"
+#include "screen.h"
+
+void screen_put_span(uint8_t x, uint8_t y, const char *s, uint8_t len) {
+    gotoxy(x, y);
+    fwrite(s, 1, len, stdout);
+}
@@ -0,0 +1,36 @@
+/**
+ * KillZone Timer - Linux host build
+ *
+ * The jiffy clock timer.h expects, counted at 60 Hz off CLOCK_MONOTONIC.
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include "timer.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+uint16_t linux_jiffies(void) {
+    return (uint16_t)(now_ns() / (NS_PER_SEC / TIMER_HZ));
+}
+
+uint16_t linux_lines(void) {
+    return (uint16_t)(now_ns() / (NS_PER_SEC / (TIMER_HZ * LINUX_LINES)));
+}
+
+/* Called while waiting for the next jiffy: the frame is done, so show it */
+void linux_idle(void) {
+    struct timespec ts;
+
+    fflush(stdout);
+    ts.tv_sec = 0;
+    ts.tv_nsec = 1000000;
+    nanosleep(&ts, NULL);
+}
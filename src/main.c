@@ -18,6 +18,7 @@
 #include "state.h"
 #include "display.h"
 #include "input.h"
+#include "frame.h"
 /* json.h is no longer needed as parsing is done in network.c */
 
 #include "constants.h"
@@ -65,6 +66,7 @@ void game_init(void) {
  */
 void game_close(void) {
     display_close();
+    input_close();
     kz_network_close();
     state_close();
 }
@@ -77,7 +79,9 @@ void game_loop(void) {
     int frame_count = 0;
     client_state_t current;
     
+    frame_init();
     while (running && frame_count < 100000) {
+        frame_begin(); /* Once per video frame */
         current = state_get_current();
         frame_count++;
         
@@ -168,6 +172,7 @@ void handle_state_joining(void) {
             
             /* Send join request immediately */
             if (kz_network_join_player(player_name, &new_player)) {
+                kz_network_set_viewport(DISPLAY_WIDTH, DISPLAY_HEIGHT);
                 state_set_current(STATE_PLAYING);
             } else {
                 state_set_error("Rejoin failed");
@@ -181,7 +186,14 @@ void handle_state_joining(void) {
     display_show_join_prompt();
     
     fflush(stdout);
-    fgets(player_name, sizeof(player_name), stdin);
+    input_queue_keys(0); /* The editor reads the keyboard itself */
+    if (!fgets(player_name, sizeof(player_name), stdin)) {
+        /* Input has ended (a host build fed from a pipe) */
+        state_set_error("No player name");
+        state_set_current(STATE_ERROR);
+        return;
+    }
+    input_queue_keys(1);
     
     /* Remove newline and carriage return */
     len = strlen(player_name);
@@ -207,6 +219,7 @@ void handle_state_joining(void) {
     }
     
     if (kz_network_join_player(player_name, &new_player)) {
+        kz_network_set_viewport(DISPLAY_WIDTH, DISPLAY_HEIGHT);
         state_set_current(STATE_PLAYING);
     } else {
         state_set_error("Server rejected join");
@@ -223,27 +236,38 @@ void handle_state_joining(void) {
 static int force_screen_refresh = 0;
 
 void handle_state_playing(void) {
-    static int frame_count = 0;
+    static uint16_t last_poll = 0;
+    static uint16_t last_status = 0;
+    static uint8_t render_skipped = 0;
+    static uint8_t show_stats = 0;
     int c;
     const char *direction = NULL;
     player_state_t *player;
     uint8_t player_count;
-    const player_state_t *others;
+    const entity_t *others;
     const char *status;
     move_result_t move_res;
+    frame_stats_t stats;
     input_cmd_t cmd; /* Moved declaration to top */
+    uint8_t keys;
     
-    /* Get world state periodically (every 5 frames) */
-    if (frame_count++ % 5 == 0) {
+    /* Take in replies every frame; ask for world state every few jiffies
+     * (on a non-blocking link this never waits for the server). A poll
+     * that falls due late in a full frame waits for the next one. */
+    kz_network_pump();
+    if (frame_has_time(NET_BUDGET) && frame_every(&last_poll, STATE_POLL_JIFFIES)) {
         if (!kz_network_get_world_state()) {
             /* Optional: handle network error during update */
         }
     }
+    frame_charge(FRAME_NET);
     
-    /* Render game world */
+    /* Render game world, unless the network has used the whole frame
+     * (never twice running, so the screen keeps moving) */
     player = (player_state_t *)state_get_local_player();
-    if (player) {
+    if (player && (render_skipped || frame_has_time(RENDER_BUDGET))) {
         int do_refresh;
+        state_interpolate_others(); /* Walk remote entities between polls */
         others = state_get_other_players(&player_count);
         
         /* Check if refresh was requested - save and reset flag */
@@ -251,10 +275,13 @@ void handle_state_playing(void) {
         force_screen_refresh = 0;
         
         display_render_game(player, others, player_count, do_refresh);
+        render_skipped = 0;
+    } else {
+        render_skipped = 1;
     }
     
-    /* Display status bar and combat message periodically (every 10 frames) */
-    if (frame_count % 10 == 0) {
+    /* Display status bar and combat message periodically */
+    if (frame_has_time(STATUS_BUDGET) && frame_every(&last_status, STATUS_JIFFIES)) {
         const char *combat_msg;
         player = (player_state_t *)state_get_local_player();
         if (player) {
@@ -268,54 +295,74 @@ void handle_state_playing(void) {
             if (combat_msg && combat_msg[0] != '\0') {
                 display_draw_combat_message(combat_msg);
             }
+            if (show_stats) {
+                frame_stats(&stats);
+                display_draw_frame_stats(&stats); /* Over the separator just drawn */
+            }
         }
     }
+    if (show_stats && frame_stats(&stats)) {
+        display_draw_frame_stats(&stats);
+    }
+    frame_charge(FRAME_RENDER);
     
     /* Tick combat message counter each frame */
     state_tick_combat_message();
     
-    /* Check for input */
-    cmd = input_check();
-    
-    switch (cmd) {
-        case CMD_UP:
-            direction = "up";
-            break;
-        case CMD_DOWN:
-            direction = "down";
-            break;
-        case CMD_LEFT:
-            direction = "left";
-            break;
-        case CMD_RIGHT:
-            direction = "right";
-            break;
-        case CMD_REFRESH:
-            /* Trigger full screen redraw */
-            force_screen_refresh = 1;
-            return;
-        case CMD_QUIT:
-            /* Show quit confirmation dialog */
-            display_show_quit_confirmation();
-            
-            /* Wait for confirmation */
-            c = input_wait_key();
-            if (c == 'y' || c == 'Y') {
-                /* Really quit - leave player and go to init */
-                kz_network_leave_player(player->id);
-                state_clear_local_player();
-                state_set_rejoining(0);
-                state_set_current(STATE_INIT);
-            } else if (c == 'n' || c == 'N') {
-                /* Don't quit - rejoin with saved name */
-                state_set_rejoining(1);
-                state_clear_other_players();
-                state_set_current(STATE_JOINING);
-            }
-            return;
-        default:
-            break;
-    }
+    /* Take in every key queued since the last frame. Each move is predicted
+     * at once; on a batching link they all go out together afterwards. */
+    for (keys = 0; keys < MAX_KEYS_PER_FRAME; keys++) {
+        cmd = input_check();
+        direction = NULL;
+        
+        switch (cmd) {
+            case CMD_NONE:
+                keys = MAX_KEYS_PER_FRAME;
+                break;
+            case CMD_UP:
+                direction = "up";
+                break;
+            case CMD_DOWN:
+                direction = "down";
+                break;
+            case CMD_LEFT:
+                direction = "left";
+                break;
+            case CMD_RIGHT:
+                direction = "right";
+                break;
+            case CMD_REFRESH:
+                /* Trigger full screen redraw */
+                force_screen_refresh = 1;
+                break;
+            case CMD_STATS:
+                /* The status bar puts the separator back when it goes off */
+                show_stats = !show_stats;
+                break;
+            case CMD_QUIT:
+                kz_network_flush_moves();
+                
+                /* Show quit confirmation dialog */
+                display_show_quit_confirmation();
+                
+                /* Wait for confirmation */
+                c = input_wait_key();
+                if (c == 'y' || c == 'Y') {
+                    /* Really quit - leave player and go to init */
+                    kz_network_leave_player(player->id);
+                    state_clear_local_player();
+                    state_set_rejoining(0);
+                    state_set_current(STATE_INIT);
+                } else if (c == 'n' || c == 'N') {
+                    /* Don't quit - rejoin with saved name */
+                    state_set_rejoining(1);
+                    state_clear_other_players();
+                    state_set_current(STATE_JOINING);
+                }
+                return;
+            default:
+                break;
+        }
         
         /* Send movement command if valid */
         if (direction) {
@@ -357,11 +404,17 @@ void handle_state_playing(void) {
                         /* If we are the loser, transition to dead state */
                         if (strcmp(move_res.loser_id, player->id) == 0) {
                             state_set_current(STATE_DEAD);
+                            return;
                         }
                     }
                 }
             }
         }
+    }
+    frame_charge(FRAME_INPUT);
+    
+    kz_network_flush_moves();
+    frame_charge(FRAME_NET);
 }
 
 /**
@@ -0,0 +1,269 @@
+/**
+ * Arena Manager
+ *
+ * Runs many independent arenas (one World each) on a pool of worker
+ * threads. Joins fill open arenas first; new arenas go to the worker
+ * with the least load, so matches spread across every core and a busy
+ * arena only shares a thread with the arenas placed beside it.
+ */
+
+const os = require('os');
+const path = require('path');
+const { Worker } = require('worker_threads');
+
+const DEFAULT_OPTIONS = {
+  workers: (os.availableParallelism ? os.availableParallelism() : os.cpus().length),
+  width: 40,         // Arena world size
+  height: 20,
+  maxPlayers: 8,     // Players per arena before a new one is opened
+  minMobs: 3,        // Mobs each arena keeps alive
+  tickMs: 100        // Arena tick interval
+};
+
+class ArenaManager {
+  /**
+   * @param {Object} options - Overrides for DEFAULT_OPTIONS
+   */
+  constructor(options = {}) {
+    this.options = { ...DEFAULT_OPTIONS, ...options };
+    this.options.workers = Math.max(1, this.options.workers);
+    this.workers = [];
+    this.arenas = new Map(); // arenaId -> {id, slot, players}
+    this.nextArenaId = 1;
+    this.nextRequestId = 1;
+  }
+
+  get width() {
+    return this.options.width;
+  }
+
+  get height() {
+    return this.options.height;
+  }
+
+  start() {
+    for (let i = 0; i < this.options.workers; i++) {
+      this.workers.push(this.spawnWorker(i));
+    }
+    console.log(`KillZone arenas running on ${this.workers.length} worker thread(s)`);
+  }
+
+  /**
+   * Terminate all workers
+   * @returns {Promise}
+   */
+  stop() {
+    const workers = this.workers;
+    this.workers = [];
+    this.arenas.clear();
+    return Promise.all(workers.map(slot => {
+      slot.stopping = true;
+      return slot.worker.terminate();
+    }));
+  }
+
+  spawnWorker(index) {
+    const worker = new Worker(path.join(__dirname, 'arena_worker.js'), {
+      workerData: { tickMs: this.options.tickMs }
+    });
+    const slot = {
+      index,
+      worker,
+      pending: new Map(), // requestId -> {resolve, reject}
+      arenas: new Set(),
+      busyMs: 0,
+      stopping: false
+    };
+
+    worker.on('message', (msg) => this.handleMessage(slot, msg));
+    worker.on('error', (err) => console.error(`Arena worker ${index} error: ${err.message}`));
+    worker.on('exit', (code) => this.handleExit(slot, code));
+    return slot;
+  }
+
+  handleMessage(slot, msg) {
+    if (msg.type === 'stats') {
+      slot.busyMs = msg.busyMs;
+      for (const report of msg.arenas) {
+        const arena = this.arenas.get(report.arenaId);
+        if (arena) {
+          arena.mobs = report.mobs;
+          arena.ticks = report.ticks;
+        }
+      }
+      return;
+    }
+
+    const request = slot.pending.get(msg.requestId);
+    if (!request) {
+      return;
+    }
+    slot.pending.delete(msg.requestId);
+    if (msg.error) {
+      request.reject(new Error(msg.error));
+    } else {
+      request.resolve(msg.result);
+    }
+  }
+
+  handleExit(slot, code) {
+    for (const request of slot.pending.values()) {
+      request.reject(new Error('Arena worker exited'));
+    }
+    slot.pending.clear();
+    for (const arenaId of slot.arenas) {
+      this.arenas.delete(arenaId);
+    }
+    slot.arenas.clear();
+    if (!slot.stopping) {
+      console.error(`Arena worker ${slot.index} exited with code ${code}`);
+      this.workers = this.workers.filter(w => w !== slot);
+    }
+  }
+
+  /**
+   * Send an op to the worker owning an arena
+   * @returns {Promise} - Resolves with the worker's result
+   */
+  request(arena, op, args) {
+    const slot = arena.slot;
+    const requestId = this.nextRequestId++;
+    return new Promise((resolve, reject) => {
+      slot.pending.set(requestId, { resolve, reject });
+      slot.worker.postMessage({ requestId, op, arenaId: arena.id, args });
+    });
+  }
+
+  /**
+   * Placement score for a worker: players first, then arenas, then measured tick time
+   */
+  workerLoad(slot) {
+    let players = 0;
+    for (const arenaId of slot.arenas) {
+      players += this.arenas.get(arenaId).players;
+    }
+    return players * 1000 + slot.arenas.size * 100 + slot.busyMs;
+  }
+
+  /**
+   * Open a new arena on the least loaded worker
+   * @returns {Object} - Arena record
+   */
+  createArena() {
+    if (this.workers.length === 0) {
+      throw new Error('Arena manager is not running');
+    }
+    let slot = this.workers[0];
+    for (const candidate of this.workers) {
+      if (this.workerLoad(candidate) < this.workerLoad(slot)) {
+        slot = candidate;
+      }
+    }
+
+    const arena = { id: this.nextArenaId++, slot, players: 0, mobs: 0, ticks: 0 };
+    this.arenas.set(arena.id, arena);
+    slot.arenas.add(arena.id);
+    // Worker messages are handled in order, so later requests need not wait for this
+    this.request(arena, 'create', {
+      width: this.options.width,
+      height: this.options.height,
+      minMobs: this.options.minMobs
+    }).catch(err => console.error(`Arena ${arena.id} create failed: ${err.message}`));
+    console.log(`  🏟️  Arena ${arena.id} opened on worker ${slot.index}`);
+    return arena;
+  }
+
+  /**
+   * Pick the fullest arena that still has room, opening one if all are full
+   */
+  pickArena() {
+    let best = null;
+    for (const arena of this.arenas.values()) {
+      if (arena.players < this.options.maxPlayers && (!best || arena.players > best.players)) {
+        best = arena;
+      }
+    }
+    return best || this.createArena();
+  }
+
+  /**
+   * Place a player into an arena
+   * @param {string} name - Player name
+   * @returns {Promise<Object>} - {arenaId, player, isReconnect}
+   */
+  async join(name) {
+    const arena = this.pickArena();
+    arena.players++; // Reserve the slot before the worker answers
+    try {
+      const result = await this.request(arena, 'join', { name });
+      return { arenaId: arena.id, ...result };
+    } catch (err) {
+      arena.players--;
+      throw err;
+    }
+  }
+
+  /**
+   * @returns {Promise<Object|null>} - Move result, null if the move was ignored
+   */
+  move(arenaId, playerId, direction) {
+    const arena = this.arenas.get(arenaId);
+    return arena ? this.request(arena, 'move', { playerId, direction }) : Promise.resolve(null);
+  }
+
+  /**
+   * @param {Object} viewport - Optional {width, height} around the player
+   * @returns {Promise<Object|null>} - Arena state snapshot
+   */
+  getState(arenaId, playerId = null, viewport = null) {
+    const arena = this.arenas.get(arenaId);
+    return arena ? this.request(arena, 'state', { playerId, viewport }) : Promise.resolve(null);
+  }
+
+  /**
+   * Remove a player, closing the arena once it is empty
+   * @returns {Promise<boolean>}
+   */
+  async leave(arenaId, playerId) {
+    const arena = this.arenas.get(arenaId);
+    if (!arena) {
+      return false;
+    }
+    const removed = await this.request(arena, 'leave', { playerId });
+    if (removed) {
+      arena.players = Math.max(0, arena.players - 1);
+    }
+    if (arena.players === 0 && this.arenas.get(arenaId) === arena) {
+      this.arenas.delete(arenaId);
+      arena.slot.arenas.delete(arenaId);
+      await this.request(arena, 'destroy');
+      console.log(`  🏟️  Arena ${arenaId} closed`);
+    }
+    return removed;
+  }
+
+  /**
+   * Arena and worker summary for the REST API
+   * @returns {Object}
+   */
+  getStats() {
+    return {
+      workers: this.workers.map(slot => ({
+        index: slot.index,
+        arenas: slot.arenas.size,
+        busyMs: slot.busyMs
+      })),
+      arenas: [...this.arenas.values()].map(arena => ({
+        id: arena.id,
+        worker: arena.slot.index,
+        players: arena.players,
+        mobs: arena.mobs,
+        ticks: arena.ticks
+      }))
+    };
+  }
+}
+
+ArenaManager.DEFAULT_OPTIONS = DEFAULT_OPTIONS;
+
+module.exports = ArenaManager;
@@ -0,0 +1,125 @@
+/**
+ * Arena Worker
+ *
+ * Worker thread entry point that owns a set of arena Worlds. Each arena
+ * ticks on this thread's timer, so a busy arena only delays arenas on the
+ * same worker. The main thread sends {requestId, op, arenaId, args} and
+ * gets back {requestId, result} or {requestId, error}.
+ */
+
+const { parentPort, workerData } = require('worker_threads');
+const World = require('./world');
+const GameRules = require('./game_rules');
+
+const TICK_MS = workerData.tickMs || 100;
+const STATS_MS = 1000;
+
+const arenas = new Map(); // arenaId -> World
+let busyMs = 0;           // Time spent ticking since the last stats report
+
+/**
+ * Find a player by id, including one a hunter removed but whose client is still connected
+ */
+function findPlayer(world, playerId) {
+  const player = world.getPlayer(playerId);
+  if (player) {
+    return player;
+  }
+  for (const disconnected of world.disconnectedPlayers.values()) {
+    if (disconnected.id === playerId) {
+      return disconnected;
+    }
+  }
+  return null;
+}
+
+function getArena(arenaId) {
+  const world = arenas.get(arenaId);
+  if (!world) {
+    throw new Error(`Unknown arena ${arenaId}`);
+  }
+  return world;
+}
+
+const ops = {
+  create(arenaId, { width, height, minMobs }) {
+    const world = new World(width, height);
+    world.minMobs = minMobs;
+    world.respawnMobs(minMobs);
+    arenas.set(arenaId, world);
+    return true;
+  },
+
+  destroy(arenaId) {
+    return arenas.delete(arenaId);
+  },
+
+  join(arenaId, { name }) {
+    const { player, isReconnect } = GameRules.joinPlayer(getArena(arenaId), name);
+    return { player: player.toJSON(), isReconnect };
+  },
+
+  move(arenaId, { playerId, direction }) {
+    const world = getArena(arenaId);
+    const player = findPlayer(world, playerId);
+    return player ? GameRules.movePlayer(world, player, direction) : null;
+  },
+
+  state(arenaId, { playerId, viewport }) {
+    const world = getArena(arenaId);
+    let area = null;
+    const viewer = playerId ? world.getPlayer(playerId) : null;
+    if (playerId) {
+      world.updatePlayerActivity(playerId);
+    }
+    if (viewer && viewport) {
+      area = world.getViewportRect(viewer.x, viewer.y, viewport.width, viewport.height);
+    }
+    return world.getSnapshot(area);
+  },
+
+  leave(arenaId, { playerId }) {
+    const world = arenas.get(arenaId);
+    if (!world || !findPlayer(world, playerId)) {
+      return false;
+    }
+    world.removePlayer(playerId);
+    return true;
+  }
+};
+
+parentPort.on('message', ({ requestId, op, arenaId, args }) => {
+  try {
+    if (!ops[op]) {
+      throw new Error(`Unknown op ${op}`);
+    }
+    parentPort.postMessage({ requestId, result: ops[op](arenaId, args || {}) });
+  } catch (e) {
+    parentPort.postMessage({ requestId, error: e.message });
+  }
+});
+
+// Simulation loop: every arena on this worker advances once per tick
+setInterval(() => {
+  const started = Date.now();
+  for (const world of arenas.values()) {
+    world.tick();
+    if (world.ticks % 100 === 0) {
+      world.respawnMobs(world.minMobs);
+    }
+    if (world.ticks % 600 === 0) {
+      world.cleanupInactivePlayers(120000);
+    }
+  }
+  busyMs += Date.now() - started;
+}, TICK_MS);
+
+// Load report used by the manager for placement and /api/arenas
+setInterval(() => {
+  const report = [];
+  for (const [arenaId, world] of arenas) {
+    report.push({ arenaId, players: world.getPlayerCount(), mobs: world.mobs.size, ticks: world.ticks });
+  }
+  parentPort.postMessage({ type: 'stats', arenas: report, busyMs });
+  busyMs = 0;
+}, STATS_MS);
@@ -0,0 +1,160 @@
+/**
+ * Client Outbox
+ *
+ * Per-socket write accounting for the TCP server.
+ * - Reliable packets (join/move replies) are always written
+ * - State snapshots use a latest-only mailbox once the client falls behind
+ * - Clients backlogged past the limits are disconnected
+ */
+
+const DEFAULT_LIMITS = {
+  snapshotHighWaterBytes: 1024,  // Above this, snapshots wait in the mailbox
+  maxBufferedBytes: 64 * 1024,   // Hard cap on bytes queued in the socket
+  stallTimeoutMs: 10000          // Max time a client may stay backlogged
+};
+
+class ClientOutbox {
+  /**
+   * @param {net.Socket} socket - Socket to write to
+   * @param {Object} limits - Overrides for DEFAULT_LIMITS
+   */
+  constructor(socket, limits = {}) {
+    this.socket = socket;
+    this.limits = { ...DEFAULT_LIMITS, ...limits };
+    this.pendingSnapshot = null;   // Newest snapshot not yet handed to the socket
+    this.backloggedSince = 0;      // Time the client first fell behind (0 = keeping up)
+    this.bytesWritten = 0;
+    this.snapshotsReplaced = 0;
+    this.closed = false;
+
+    // 'drain' only follows a write() that returned false (the socket's own
+    // high-water mark, far above snapshotHighWaterBytes), so a held snapshot
+    // is also retried as each write reaches the kernel and from the sweep
+    this.onDrain = () => this.flush();
+    this.onWritten = () => this.flush();
+    socket.on('drain', this.onDrain);
+  }
+
+  /**
+   * Bytes handed to the socket but not yet flushed to the kernel
+   * @returns {number}
+   */
+  getBufferedBytes() {
+    return this.socket.writableLength || 0;
+  }
+
+  /**
+   * Write a packet that must be delivered (request/response traffic)
+   * @param {Buffer} buf - Packet bytes
+   * @returns {boolean} - False if the client was disconnected
+   */
+  send(buf) {
+    if (this.closed) {
+      return false;
+    }
+    this.write(buf);
+    return this.checkLimits();
+  }
+
+  /**
+   * Write a state snapshot, replacing any older snapshot still waiting
+   * @param {Buffer} buf - Snapshot bytes
+   * @returns {boolean} - False if the client was disconnected
+   */
+  sendSnapshot(buf) {
+    if (this.closed) {
+      return false;
+    }
+    if (this.getBufferedBytes() > this.limits.snapshotHighWaterBytes) {
+      if (this.pendingSnapshot) {
+        this.snapshotsReplaced++;
+      }
+      this.pendingSnapshot = buf;
+    } else {
+      this.pendingSnapshot = null;
+      this.write(buf);
+    }
+    return this.checkLimits();
+  }
+
+  /**
+   * Hand the waiting snapshot to the socket once it has drained
+   * @param {number} now - Current time in ms
+   * @returns {boolean} - False if the client was disconnected
+   */
+  flush(now = Date.now()) {
+    if (this.closed) {
+      return false;
+    }
+    if (this.pendingSnapshot && this.getBufferedBytes() <= this.limits.snapshotHighWaterBytes) {
+      const buf = this.pendingSnapshot;
+      this.pendingSnapshot = null;
+      this.write(buf);
+    }
+    return this.checkLimits(now);
+  }
+
+  write(buf) {
+    this.bytesWritten += buf.length;
+    this.socket.write(buf, this.onWritten);
+  }
+
+  /**
+   * Track how long the client has been behind and disconnect it when stuck
+   * @param {number} now - Current time in ms
+   * @returns {boolean} - False if the client was disconnected
+   */
+  checkLimits(now = Date.now()) {
+    if (this.closed) {
+      return false;
+    }
+    const buffered = this.getBufferedBytes();
+
+    if (buffered <= this.limits.snapshotHighWaterBytes && !this.pendingSnapshot) {
+      this.backloggedSince = 0;
+      return true;
+    }
+    if (this.backloggedSince === 0) {
+      this.backloggedSince = now;
+    }
+
+    if (buffered > this.limits.maxBufferedBytes) {
+      this.disconnect(`${buffered} bytes buffered`);
+      return false;
+    }
+    if (now - this.backloggedSince > this.limits.stallTimeoutMs) {
+      this.disconnect(`backlogged for ${now - this.backloggedSince}ms`);
+      return false;
+    }
+    return true;
+  }
+
+  disconnect(reason) {
+    this.close();
+    console.log(`  🐌 Dropping slow TCP client: ${reason}`);
+    this.socket.destroy();
+  }
+
+  close() {
+    this.closed = true;
+    this.pendingSnapshot = null;
+    this.socket.removeListener('drain', this.onDrain);
+  }
+
+  /**
+   * Get outbox counters for logging
+   * @returns {Object}
+   */
+  getStats() {
+    return {
+      bufferedBytes: this.getBufferedBytes(),
+      bytesWritten: this.bytesWritten,
+      snapshotsReplaced: this.snapshotsReplaced,
+      snapshotPending: this.pendingSnapshot !== null
+    };
+  }
+}
+
+ClientOutbox.DEFAULT_LIMITS = DEFAULT_LIMITS;
+
+module.exports = ClientOutbox;
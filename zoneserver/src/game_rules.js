@@ -0,0 +1,120 @@
+/**
+ * Game Rules
+ *
+ * Join and move rules shared by the TCP server and the arena workers,
+ * so a player behaves the same whichever process owns its world.
+ */
+
+const Player = require('./player');
+const CombatResolver = require('./combat');
+
+const MAX_MESSAGE_LENGTH = 39; // Fits the client status line
+
+class GameRules {
+  /**
+   * Pick a random free spawn position
+   * @param {World} world - World to spawn in
+   * @returns {Object} - {x, y}
+   */
+  static findSpawn(world) {
+    let x, y;
+    let attempts = 0;
+    do {
+      x = Math.floor(Math.random() * world.width);
+      y = Math.floor(Math.random() * world.height);
+      attempts++;
+    } while (world.getPlayerAtPosition(x, y) !== null && attempts < 10);
+    return { x, y };
+  }
+
+  /**
+   * Add a player by name, restoring a previously disconnected player with that name
+   * @param {World} world - World to join
+   * @param {string} name - Player name
+   * @returns {Object} - {player, isReconnect}
+   */
+  static joinPlayer(world, name) {
+    const disconnectedPlayer = world.getDisconnectedPlayer(name);
+    const spawn = GameRules.findSpawn(world);
+    let player;
+
+    if (disconnectedPlayer) {
+      player = disconnectedPlayer;
+      player.status = 'alive';
+      player.health = 100;
+      player.setPosition(spawn.x, spawn.y);
+      world.removeDisconnectedPlayer(name);
+      world.addPlayer(player);
+      world.setRejoinMessage(name);
+    } else {
+      const playerId = `player_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`;
+      player = new Player(playerId, name, spawn.x, spawn.y);
+      world.addPlayer(player);
+      world.setJoinMessage(name);
+    }
+
+    return { player, isReconnect: disconnectedPlayer !== null };
+  }
+
+  /**
+   * Step a player one cell. Bumping into a player or mob fights it instead of moving.
+   * @param {World} world - World the player is in
+   * @param {Player} player - Moving player
+   * @param {string} direction - 'up', 'down', 'left' or 'right'
+   * @returns {Object|null} - {x, y, health, collision, message}, null for an invalid move
+   */
+  static movePlayer(world, player, direction) {
+    let newX = player.x;
+    let newY = player.y;
+
+    switch (direction) {
+      case 'up': newY = Math.max(0, newY - 1); break;
+      case 'down': newY = Math.min(world.height - 1, newY + 1); break;
+      case 'left': newX = Math.max(0, newX - 1); break;
+      case 'right': newX = Math.min(world.width - 1, newX + 1); break;
+      default: return null;
+    }
+
+    world.updatePlayerActivity(player.id);
+    if (!world.isValidPosition(newX, newY)) {
+      return null;
+    }
+
+    const collidingPlayer = world.getPlayerAtPosition(newX, newY, player.id);
+    const collidingMob = collidingPlayer ? null : world.getMobAtPosition(newX, newY);
+    const opponent = collidingPlayer || collidingMob;
+    let message = '';
+
+    if (opponent) {
+      const result = CombatResolver.resolveBattle(player, opponent);
+      console.log(`  ⚔️  Combat: "${player.name}" vs "${opponent.name}" - Winner: "${result.finalWinnerName}"`);
+      message = `${result.finalWinnerName} defeats ${result.finalLoserName}!`;
+      if (result.finalLoserId === player.id) {
+        world.removePlayer(player.id);
+        world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'player');
+      } else if (collidingPlayer) {
+        world.removePlayer(opponent.id);
+        world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'player');
+      } else {
+        world.removeMob(opponent.id);
+        world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'mob');
+      }
+      world.setLastCombat(result);
+    } else {
+      world.moveEntity(player, newX, newY);
+    }
+
+    return {
+      x: player.x,
+      y: player.y,
+      health: player.health,
+      collision: opponent !== null,
+      message: message.substring(0, MAX_MESSAGE_LENGTH)
+    };
+  }
+}
+
+GameRules.DIRECTIONS = { u: 'up', d: 'down', l: 'left', r: 'right' };
+GameRules.MAX_MESSAGE_LENGTH = MAX_MESSAGE_LENGTH;
+
+module.exports = GameRules;
@@ -0,0 +1,351 @@
+/**
+ * IO Pool
+ *
+ * Moves TCP client handling off the simulation thread. The world stays
+ * on this thread and publishes its entity table into a SharedSnapshot
+ * after every tick; N IO worker threads accept connections, answer state
+ * requests straight from the snapshot, and forward joins/moves/leaves
+ * over one pair of SPSC rings per worker.
+ *
+ * Workers share the listening port with SO_REUSEPORT where Node supports
+ * it (22.12+). Elsewhere the first worker binds the port and the others
+ * accept on the same socket, each through its own descriptor for it; the
+ * kernel hands every connection to whichever worker accepts first. Windows,
+ * which cannot pass the descriptor on, falls back to one port per worker
+ * (port, port + 1, ...).
+ */
+
+const os = require('os');
+const path = require('path');
+const { Worker } = require('worker_threads');
+const GameRules = require('./game_rules');
+const SharedSnapshot = require('./shared_snapshot');
+const SharedWorldClient = require('./shared_world_client');
+const SpscRing = require('./spsc_ring');
+
+const { OPS } = SharedWorldClient;
+
+const DEFAULT_OPTIONS = {
+  workers: Math.max(1, (os.availableParallelism ? os.availableParallelism() : os.cpus().length) - 1),
+  port: 3001,
+  tickMs: 100,         // Simulation tick interval
+  capacity: 4096,      // Max entities published per snapshot
+  ringBytes: 65536,    // Per-direction ring size for each worker
+  reusePort: null,     // null = use it when the runtime supports it
+  statsTimeoutMs: 1000, // Workers that have not reported by then are left out of getStats
+  outboxLimits: {}
+};
+
+/**
+ * Whether net.Server.listen accepts reusePort (Node 22.12+, 23.1+)
+ * @returns {boolean}
+ */
+function supportsReusePort() {
+  const [major, minor] = process.versions.node.split('.').map(Number);
+  return major > 23 || (major === 23 && minor >= 1) || (major === 22 && minor >= 12);
+}
+
+class IoPool {
+  /**
+   * @param {World} world - World simulated on this thread
+   * @param {Object} options - Overrides for DEFAULT_OPTIONS
+   */
+  constructor(world, options = {}) {
+    this.world = world;
+    this.options = { ...DEFAULT_OPTIONS, ...options };
+    if (this.options.reusePort === null) {
+      this.options.reusePort = supportsReusePort();
+    }
+    this.snapshot = new SharedSnapshot(this.options.capacity);
+    this.workers = [];
+    this.handles = new Map();         // playerId -> handle
+    this.playersByHandle = new Map(); // handle -> Player (kept after a kill so moves still answer)
+    this.nextHandle = 1;
+    this.nextStatsId = 1;
+    this.tickTimer = null;
+    this.handleOf = (player) => this.handleFor(player);
+  }
+
+  /**
+   * Numeric handle of a player, allocated on first sight so players joined
+   * over REST get one from the same counter as ring joins
+   * @param {Player} player
+   * @returns {number}
+   */
+  handleFor(player) {
+    let handle = this.handles.get(player.id);
+    if (!handle) {
+      handle = this.nextHandle++;
+      this.handles.set(player.id, handle);
+    }
+    return handle;
+  }
+
+  /**
+   * Forget handles of players that left without a ring LEAVE (REST joins)
+   */
+  pruneHandles() {
+    for (const [playerId, handle] of this.handles) {
+      if (!this.playersByHandle.has(handle) && !this.world.getPlayer(playerId)) {
+        this.handles.delete(playerId);
+      }
+    }
+  }
+
+  /**
+   * Spawn the IO workers and start ticking the world
+   * @returns {Promise<number[]>} - Port each worker listens on
+   */
+  start() {
+    this.publish();
+    const count = this.options.workers;
+    let ready;
+    if (this.options.reusePort) {
+      ready = Promise.all([...Array(count).keys()].map(i => this.spawnWorker(i, this.options.port)));
+    } else if (process.platform !== 'win32') {
+      ready = this.spawnWorker(0, this.options.port).then((listener) => Promise.all([
+        listener,
+        ...[...Array(count - 1).keys()].map(i => this.spawnWorker(i + 1, listener.port, listener.fd))
+      ]));
+    } else {
+      const portOf = (i) => (this.options.port === 0 ? 0 : this.options.port + i);
+      ready = Promise.all([...Array(count).keys()].map(i => this.spawnWorker(i, portOf(i))));
+    }
+    this.tickTimer = setInterval(() => this.step(), this.options.tickMs);
+
+    this.ready = ready.then(listeners => listeners.map(l => l.port));
+    return this.ready.then((ports) => {
+      const mode = this.options.reusePort ? 'shared with SO_REUSEPORT'
+        : process.platform !== 'win32' ? 'one shared listener' : 'one per worker';
+      console.log(`KillZone TCP IO workers: ${ports.length} on port(s) ${[...new Set(ports)].join(', ')} (${mode})`);
+      return ports;
+    });
+  }
+
+  /**
+   * @param {number} listenFd - Listening socket to accept on instead of binding port
+   * @returns {Promise<Object>} - {port, fd} of the worker's listener
+   */
+  spawnWorker(index, port, listenFd = null) {
+    const slot = {
+      index,
+      port,
+      toSim: new SpscRing(this.options.ringBytes),
+      fromSim: new SpscRing(this.options.ringBytes),
+      statsWaiting: new Map(), // requestId -> resolve
+      replyBacklog: [],        // Replies waiting for ring space
+      retryTimer: null,
+      worker: null
+    };
+    slot.worker = new Worker(path.join(__dirname, 'io_worker.js'), {
+      workerData: {
+        snapshot: this.snapshot.buffer,
+        toSim: slot.toSim.buffer,
+        fromSim: slot.fromSim.buffer,
+        port,
+        listenFd,
+        reusePort: this.options.reusePort,
+        tickHz: Math.round(1000 / this.options.tickMs),
+        outboxLimits: this.options.outboxLimits
+      }
+    });
+    this.workers.push(slot);
+
+    return new Promise((resolve, reject) => {
+      slot.worker.on('message', (msg) => {
+        if (msg.type === 'kick') {
+          this.drain(slot);
+        } else if (msg.type === 'stats') {
+          const resolve = slot.statsWaiting.get(msg.requestId);
+          if (resolve) {
+            slot.statsWaiting.delete(msg.requestId);
+            resolve(msg.stats);
+          }
+        } else if (msg.type === 'listening') {
+          slot.port = msg.port;
+          resolve({ port: msg.port, fd: msg.fd });
+        }
+      });
+      slot.worker.on('error', (err) => {
+        console.error(`IO worker ${index} error: ${err.message}`);
+        reject(err);
+      });
+    });
+  }
+
+  /**
+   * Stop ticking and shut the workers down
+   * @returns {Promise}
+   */
+  stop() {
+    clearInterval(this.tickTimer);
+    this.tickTimer = null;
+    const workers = this.workers;
+    this.workers = [];
+    return Promise.all(workers.map(slot => new Promise((resolve) => {
+      clearTimeout(slot.retryTimer);
+      slot.worker.once('exit', resolve);
+      slot.worker.postMessage({ type: 'stop' });
+    })));
+  }
+
+  /**
+   * Connection metrics from every worker, merged into TcpServer.getStats form
+   * @returns {Promise<Object>} - Each connection also carries its worker index
+   */
+  async getStats() {
+    const requestId = this.nextStatsId++;
+    const replies = await Promise.all(this.workers.map(slot => new Promise((resolve) => {
+      const timer = setTimeout(() => {
+        slot.statsWaiting.delete(requestId);
+        resolve(null);
+      }, this.options.statsTimeoutMs);
+      slot.statsWaiting.set(requestId, (stats) => {
+        clearTimeout(timer);
+        resolve(stats);
+      });
+      slot.worker.postMessage({ type: 'stats', requestId });
+    })));
+
+    const connections = [];
+    let resumableSessions = 0;
+    replies.forEach((stats, index) => {
+      if (stats) {
+        stats.connections.forEach(c => connections.push({ worker: index, ...c }));
+        resumableSessions += stats.resumableSessions;
+      }
+    });
+    const measured = connections.filter(c => c.rttMs > 0);
+    return {
+      connections,
+      resumableSessions,
+      meanRttMs: measured.length ? Math.round(measured.reduce((sum, c) => sum + c.rttMs, 0) / measured.length) : 0,
+      workersReporting: replies.filter(Boolean).length
+    };
+  }
+
+  /**
+   * One simulation step: tick, apply queued commands, publish
+   */
+  step() {
+    this.world.tick();
+    for (const slot of this.workers) {
+      this.drain(slot, false);
+    }
+    this.pruneHandles();
+    this.publish();
+  }
+
+  publish() {
+    this.snapshot.write(this.world, this.handleOf);
+  }
+
+  /**
+   * Apply every command a worker has queued and send the replies
+   * @param {boolean} publish - Publish a fresh snapshot if anything changed
+   */
+  drain(slot, publish = true) {
+    slot.toSim.clearKick();
+    let handled = 0;
+    let msg;
+    while ((msg = slot.toSim.pop()) !== null) {
+      slot.replyBacklog.push(this.handleCommand(msg));
+      handled++;
+    }
+    if (handled > 0) {
+      if (publish) {
+        this.publish();
+      }
+      this.flushReplies(slot);
+    }
+  }
+
+  /**
+   * Push backlogged replies; the worker's requests stay pending until theirs arrives
+   */
+  flushReplies(slot) {
+    let pushed = false;
+    while (slot.replyBacklog.length > 0 && slot.fromSim.push(slot.replyBacklog[0])) {
+      slot.replyBacklog.shift();
+      pushed = true;
+    }
+    if (pushed && slot.fromSim.claimKick()) {
+      slot.worker.postMessage({ type: 'kick' });
+    }
+    if (slot.replyBacklog.length > 0 && !slot.retryTimer) {
+      // Ring full: the worker is behind, try again shortly
+      slot.retryTimer = setTimeout(() => {
+        slot.retryTimer = null;
+        this.flushReplies(slot);
+      }, 1);
+    }
+  }
+
+  /**
+   * Run one ring command against the world
+   * @param {Buffer} msg - [Op] [RequestId u32] [Body...]
+   * @returns {Buffer} - Reply with the same op and request id
+   */
+  handleCommand(msg) {
+    const op = msg[0];
+    const head = msg.subarray(0, 5);
+    const body = msg.subarray(5);
+
+    switch (op) {
+      case OPS.JOIN: {
+        const name = body.subarray(1, 1 + body[0]).toString();
+        const { player } = GameRules.joinPlayer(this.world, name);
+        const handle = this.handleFor(player);
+        this.playersByHandle.set(handle, player);
+
+        const idBuf = Buffer.from(player.id);
+        const reply = Buffer.alloc(10 + idBuf.length);
+        reply.writeUInt32LE(handle, 0);
+        reply.writeUInt16LE(player.x, 4);
+        reply.writeUInt16LE(player.y, 6);
+        reply.writeUInt8(player.health, 8);
+        reply.writeUInt8(idBuf.length, 9);
+        idBuf.copy(reply, 10);
+        return Buffer.concat([head, reply]);
+      }
+
+      case OPS.MOVE: {
+        const player = this.playersByHandle.get(body.readUInt32LE(0));
+        const direction = GameRules.DIRECTIONS[String.fromCharCode(body[4])];
+        const result = player ? GameRules.movePlayer(this.world, player, direction) : null;
+        if (!result) {
+          return Buffer.concat([head, Buffer.from([0])]);
+        }
+        const msgBuf = Buffer.from(result.message);
+        const reply = Buffer.alloc(8 + msgBuf.length);
+        reply.writeUInt8(1, 0);
+        reply.writeUInt16LE(result.x, 1);
+        reply.writeUInt16LE(result.y, 3);
+        reply.writeUInt8(result.health, 5);
+        reply.writeUInt8(result.collision ? 1 : 0, 6);
+        reply.writeUInt8(msgBuf.length, 7);
+        msgBuf.copy(reply, 8);
+        return Buffer.concat([head, reply]);
+      }
+
+      case OPS.LEAVE: {
+        const handle = body.readUInt32LE(0);
+        const player = this.playersByHandle.get(handle);
+        this.playersByHandle.delete(handle);
+        if (player) {
+          this.handles.delete(player.id);
+          this.world.removePlayer(player.id);
+        }
+        return Buffer.concat([head, Buffer.from([player ? 1 : 0])]);
+      }
+
+      default:
+        return Buffer.concat([head, Buffer.from([0])]);
+    }
+  }
+}
+
+IoPool.DEFAULT_OPTIONS = DEFAULT_OPTIONS;
+IoPool.supportsReusePort = supportsReusePort;
+
+module.exports = IoPool;
@@ -0,0 +1,59 @@
+/**
+ * IO Worker
+ *
+ * Worker thread entry point that runs a TcpServer front-end for the
+ * shared world. Socket IO, packet parsing and state encoding happen here;
+ * the simulation thread only sees joins, moves and leaves.
+ */
+
+const path = require('path');
+const { spawn } = require('child_process');
+const { parentPort, workerData } = require('worker_threads');
+const TcpServer = require('./tcp_server');
+const SharedSnapshot = require('./shared_snapshot');
+const SharedWorldClient = require('./shared_world_client');
+const SpscRing = require('./spsc_ring');
+
+const client = new SharedWorldClient(
+  new SharedSnapshot(workerData.snapshot),
+  new SpscRing(workerData.toSim),
+  new SpscRing(workerData.fromSim),
+  () => parentPort.postMessage({ type: 'kick' })
+);
+
+const tcp = new TcpServer(null, workerData.port, {
+  arenas: client,
+  reusePort: workerData.reusePort,
+  tickHz: workerData.tickHz,
+  ...workerData.outboxLimits
+});
+
+parentPort.on('message', (msg) => {
+  if (msg.type === 'kick') {
+    client.drainReplies();
+  } else if (msg.type === 'stats') {
+    parentPort.postMessage({ type: 'stats', requestId: msg.requestId, stats: tcp.getStats() });
+  } else if (msg.type === 'stop') {
+    tcp.stop(() => process.exit(0));
+  }
+});
+
+tcp.server.once('listening', () => {
+  parentPort.postMessage({ type: 'listening', port: tcp.server.address().port, fd: tcp.server._handle.fd });
+});
+
+if (workerData.listenFd === null) {
+  tcp.start();
+} else {
+  // Accept on the first worker's socket through a descriptor of our own (see listener_broker.js)
+  const broker = spawn(process.execPath, [path.join(__dirname, 'listener_broker.js')], {
+    stdio: ['ignore', 'inherit', 'inherit', workerData.listenFd, 'ipc']
+  });
+  broker.once('message', (msg, listener) => {
+    tcp.start(listener._handle);
+    broker.send('done');
+  });
+  broker.once('error', (err) => {
+    throw err;
+  });
+}
@@ -0,0 +1,15 @@
+/**
+ * Listener Broker
+ *
+ * Child process entry point that hands a listening socket back to the IO
+ * worker that spawned it. The worker passes the shared listener in as fd 3;
+ * sending it over the IPC channel gives the worker a descriptor of its own
+ * for the same socket, which worker threads cannot share with each other
+ * directly. Used where SO_REUSEPORT is not available.
+ */
+
+const net = require('net');
+
+const listener = new net.Socket({ fd: 3, readable: false, writable: false });
+process.send('listener', listener);
+process.once('message', () => process.exit(0));
@@ -5,7 +5,7 @@
  */
 
 const express = require('express');
-const Player = require('../player');
+const GameRules = require('../game_rules');
 const CollisionDetector = require('../collision');
 const CombatResolver = require('../combat');
 
@@ -30,6 +30,7 @@ function createApiRoutes(world) {
   /**
    * GET /api/world/state
    * Get current world snapshot
+   * Optional viewWidth/viewHeight (with playerId) limit entities to that player's viewport
    */
   router.get('/world/state', (req, res) => {
     // Update activity for any player that requests state
@@ -37,7 +38,16 @@ function createApiRoutes(world) {
     if (playerId) {
       world.updatePlayerActivity(playerId);
     }
-    res.status(200).json(world.getState());
+
+    let area = null;
+    const viewWidth = parseInt(req.query.viewWidth, 10);
+    const viewHeight = parseInt(req.query.viewHeight, 10);
+    const viewer = playerId ? world.getPlayer(playerId) : null;
+    if (viewer && viewWidth > 0 && viewHeight > 0) {
+      area = world.getViewportRect(viewer.x, viewer.y, viewWidth, viewHeight);
+    }
+
+    res.status(200).json(world.getState(area));
   });
 
   /**
@@ -57,56 +67,11 @@ function createApiRoutes(world) {
       });
     }
 
-    // Check if this player was previously disconnected
-    const disconnectedPlayer = world.getDisconnectedPlayer(name);
-    let player;
-    let isReconnect = false;
-
-    if (disconnectedPlayer) {
-      // Restore existing player with their original ID
-      player = disconnectedPlayer;
-      
-      // Reset player state for rejoin
-      player.status = 'alive';
-      player.health = 100;
-      
-      // Generate new spawn position
-      let x, y;
-      let attempts = 0;
-      do {
-        x = Math.floor(Math.random() * world.width);
-        y = Math.floor(Math.random() * world.height);
-        attempts++;
-      } while (world.getPlayerAtPosition(x, y) !== null && attempts < 10);
-      
-      player.setPosition(x, y);
-      
-      // Remove from disconnected and add back to active players
-      world.removeDisconnectedPlayer(name);
-      world.addPlayer(player);
-      
-      isReconnect = true;
-      world.setRejoinMessage(name);
-      console.log(`  🔄 Player reconnected: "${name}" (ID: ${player.id}) at position (${x}, ${y}) - Total players: ${world.getPlayerCount()}`);
+    const { player, isReconnect } = GameRules.joinPlayer(world, name);
+    if (isReconnect) {
+      console.log(`  🔄 Player reconnected: "${name}" (ID: ${player.id}) at position (${player.x}, ${player.y}) - Total players: ${world.getPlayerCount()}`);
     } else {
-      // New player - generate fresh ID
-      const playerId = `player_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`;
-      
-      // Generate random spawn position
-      let x, y;
-      let attempts = 0;
-      do {
-        x = Math.floor(Math.random() * world.width);
-        y = Math.floor(Math.random() * world.height);
-        attempts++;
-      } while (world.getPlayerAtPosition(x, y) !== null && attempts < 10);
-
-      // Create new player
-      player = new Player(playerId, name, x, y);
-      world.addPlayer(player);
-      
-      world.setJoinMessage(name);
-      console.log(`  👤 Player joined: "${name}" (ID: ${playerId}) at position (${x}, ${y}) - Total players: ${world.getPlayerCount()}`);
+      console.log(`  👤 Player joined: "${name}" (ID: ${player.id}) at position (${player.x}, ${player.y}) - Total players: ${world.getPlayerCount()}`);
     }
 
     res.status(201).json({
@@ -202,7 +167,7 @@ function createApiRoutes(world) {
     }
 
     // Update position
-    player.setPosition(newX, newY);
+    world.moveEntity(player, newX, newY);
 
     // Check for collision with other players
     const collidingPlayer = world.getPlayerAtPosition(newX, newY, playerId);
@@ -0,0 +1,105 @@
+/**
+ * Arena Route Definitions
+ *
+ * REST endpoints for instanced arenas. Each call is forwarded to the
+ * worker thread running the arena.
+ */
+
+const express = require('express');
+
+function createArenaRoutes(arenas) {
+  const router = express.Router();
+
+  // Forward rejected worker requests to the error handler
+  const handle = (fn) => (req, res, next) => fn(req, res).catch(next);
+
+  /**
+   * GET /api/arenas
+   * List arenas and worker load
+   */
+  router.get('/arenas', (req, res) => {
+    res.status(200).json({ success: true, ...arenas.getStats() });
+  });
+
+  /**
+   * POST /api/arenas/join
+   * Place a player in the fullest arena with room
+   */
+  router.post('/arenas/join', handle(async (req, res) => {
+    const { name } = req.body;
+    if (!name || typeof name !== 'string' || name.trim().length === 0) {
+      return res.status(400).json({
+        success: false,
+        error: 'Player name is required and must be a non-empty string'
+      });
+    }
+
+    const { arenaId, player, isReconnect } = await arenas.join(name);
+    console.log(`  👤 Player joined arena ${arenaId}: "${name}" (ID: ${player.id})`);
+    res.status(201).json({
+      success: true,
+      arenaId,
+      ...player,
+      reconnect: isReconnect
+    });
+  }));
+
+  /**
+   * GET /api/arenas/:arenaId/state
+   * Arena snapshot; viewWidth/viewHeight with playerId limit it to that player's viewport
+   */
+  router.get('/arenas/:arenaId/state', handle(async (req, res) => {
+    const playerId = req.query.playerId || null;
+    const viewWidth = parseInt(req.query.viewWidth, 10);
+    const viewHeight = parseInt(req.query.viewHeight, 10);
+    const viewport = viewWidth > 0 && viewHeight > 0 ? { width: viewWidth, height: viewHeight } : null;
+
+    const state = await arenas.getState(parseInt(req.params.arenaId, 10), playerId, viewport);
+    if (!state) {
+      return res.status(404).json({ success: false, error: 'Arena not found' });
+    }
+    res.status(200).json(state);
+  }));
+
+  /**
+   * POST /api/arenas/:arenaId/player/:id/move
+   * Step a player; bumping into another entity fights it
+   */
+  router.post('/arenas/:arenaId/player/:id/move', handle(async (req, res) => {
+    const { direction } = req.body;
+    const validDirections = ['up', 'down', 'left', 'right'];
+    if (!direction || !validDirections.includes(direction)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Invalid direction. Must be: up, down, left, right'
+      });
+    }
+
+    const result = await arenas.move(parseInt(req.params.arenaId, 10), req.params.id, direction);
+    if (!result) {
+      return res.status(404).json({ success: false, error: 'Player not found' });
+    }
+    res.status(200).json({ success: true, playerId: req.params.id, ...result });
+  }));
+
+  /**
+   * POST /api/arenas/:arenaId/leave
+   * Remove a player; empty arenas are closed
+   */
+  router.post('/arenas/:arenaId/leave', handle(async (req, res) => {
+    const { id } = req.body;
+    if (!id) {
+      return res.status(400).json({ success: false, error: 'Player ID is required' });
+    }
+
+    const removed = await arenas.leave(parseInt(req.params.arenaId, 10), id);
+    if (!removed) {
+      return res.status(404).json({ success: false, error: 'Player not found' });
+    }
+    res.status(200).json({ success: true, id });
+  }));
+
+  return router;
+}
+
+module.exports = createArenaRoutes;
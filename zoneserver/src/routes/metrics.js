@@ -0,0 +1,31 @@
+/**
+ * Metrics Route Definitions
+ *
+ * Connection metrics for the TCP front-end: the TcpServer on this thread,
+ * or the IoPool collecting them from its workers.
+ */
+
+const express = require('express');
+
+/**
+ * @param {TcpServer|IoPool} source - Anything with getStats(), which may return a Promise
+ */
+function createMetricsRoutes(source) {
+  const router = express.Router();
+
+  /**
+   * GET /api/metrics
+   * Per-connection round-trip times, negotiated codec and outbox counters
+   */
+  router.get('/metrics', async (req, res, next) => {
+    try {
+      res.status(200).json({ success: true, tcp: await source.getStats() });
+    } catch (err) {
+      next(err);
+    }
+  });
+
+  return router;
+}
+
+module.exports = createMetricsRoutes;
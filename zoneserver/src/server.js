@@ -8,14 +8,33 @@
 const express = require('express');
 const cors = require('cors');
 const World = require('./world');
+const ZoneManager = require('./zone_manager');
 const Mob = require('./mob');
+const ArenaManager = require('./arena_manager');
+const IoPool = require('./io_pool');
+const UdpServer = require('./udp_server');
 const createApiRoutes = require('./routes/api');
+const createArenaRoutes = require('./routes/arenas');
+const createMetricsRoutes = require('./routes/metrics');
 const TcpServer = require('./tcp_server');
 
 const PORT = process.env.PORT || 3000;
+const WORLD_WIDTH = parseInt(process.env.WORLD_WIDTH, 10) || 40;
+const WORLD_HEIGHT = parseInt(process.env.WORLD_HEIGHT, 10) || 20;
+const ZONES = /^(\d+)x(\d+)$/.exec(process.env.ZONES || '');  // e.g. ZONES=2x2
+const ARENA_WORKERS = parseInt(process.env.ARENA_WORKERS, 10) || 0;  // 0 = single shared world
+const IO_WORKERS = parseInt(process.env.IO_WORKERS, 10) || 0;  // 0 = TCP on the simulation thread
+const UDP_PORT = parseInt(process.env.UDP_PORT, 10) || 0;  // 0 = no UDP snapshot channel
+
+// Zones tick on their own timers and IO workers publish a single World, so the two don't combine
+if (ZONES && IO_WORKERS > 0 && ARENA_WORKERS === 0) {
+  throw new Error('ZONES cannot be combined with IO_WORKERS; unset one of them');
+}
 
-// Initialize world
-const world = new World(40, 20);
+// Initialize world (split into independently ticked zones when ZONES is set)
+const world = ZONES
+  ? new ZoneManager(WORLD_WIDTH, WORLD_HEIGHT, parseInt(ZONES[1], 10), parseInt(ZONES[2], 10))
+  : new World(WORLD_WIDTH, WORLD_HEIGHT);
 
 // Spawn initial mobs for testing multi-player rendering
 function spawnMobs() {
@@ -76,8 +95,20 @@ app.use((req, res, next) => {
   next();
 });
 
+// Instanced arenas on worker threads (TCP joins are matched into arenas)
+const arenas = ARENA_WORKERS > 0 ? new ArenaManager({ workers: ARENA_WORKERS }) : null;
+
+// TCP front-end on this thread; with IO workers each worker runs its own
+const tickHz = arenas ? Math.round(1000 / arenas.options.tickMs) : (world.zones ? 10 : 0);
+const tcpServer = IO_WORKERS > 0 && !arenas ? null : new TcpServer(world, 3001, { arenas, tickHz });
+const ioPool = tcpServer ? null : new IoPool(world, { workers: IO_WORKERS, port: 3001 });
+
 // API routes
 app.use('/api', createApiRoutes(world));
+if (arenas) {
+  app.use('/api', createArenaRoutes(arenas));
+}
+app.use('/api', createMetricsRoutes(tcpServer || ioPool));
 
 // Error handling middleware
 app.use((err, req, res, next) => {
@@ -100,12 +131,29 @@ app.use((req, res) => {
 let server;
 if (process.env.NODE_ENV !== 'test') {
   // Start TCP Server
-  const tcpServer = new TcpServer(world, 3001);
-  tcpServer.start();
+  if (arenas) {
+    arenas.start();
+  }
+  if (ioPool) {
+    // TCP clients are served by worker threads reading a shared snapshot of the world
+    ioPool.start();
+  } else {
+    tcpServer.start();
+
+    // Optional unreliable snapshot channel for clients on the shared world
+    if (UDP_PORT > 0 && !arenas) {
+      const udpServer = new UdpServer(world, UDP_PORT, tcpServer);
+      udpServer.start();
+    }
+  }
 
   server = app.listen(PORT, () => {
     console.log(`KillZone Server running on http://localhost:${PORT}`);
-    console.log(`World dimensions: 40x20`);
+    console.log(`World dimensions: ${world.width}x${world.height}`);
+    if (world.zones) {
+      console.log(`World zones: ${world.zonesX}x${world.zonesY}`);
+      world.start(100);
+    }
     console.log(`API health check: GET http://localhost:${PORT}/api/health`);
 
     // Spawn mobs for testing
@@ -142,4 +190,4 @@ if (process.env.NODE_ENV !== 'test') {
   });
 }
 
-module.exports = { app, world };
+module.exports = { app, world, tcpServer };
@@ -0,0 +1,164 @@
+/**
+ * Shared Snapshot
+ *
+ * The world's entity table published into a SharedArrayBuffer so other
+ * threads can read it without messaging the simulation. A seqlock guards
+ * it: the single writer makes the sequence odd while it writes and even
+ * when done, and readers retry any copy that overlapped a write.
+ *
+ * Entities are stored as parallel arrays (kind, x, y, handle). Player
+ * handles are numeric ids assigned by the writer's owner; mob handles are
+ * numbered by the writer itself, one per mob for as long as it lives. The
+ * two ranges overlap, so a handle only identifies an entity together with
+ * whether it is a player.
+ */
+
+const KIND_PLAYER = 1;
+const KIND_MOB = 2;
+const KIND_HUNTER = 3;
+
+const SEQ = 0;
+const COUNT = 1;
+const TICKS = 2;
+const MSG_LEN = 3;
+const WIDTH = 4;
+const HEIGHT = 5;
+const HEADER_INTS = 8;
+const MESSAGE_BYTES = 64;
+const MAX_READ_ATTEMPTS = 64;
+
+class SharedSnapshot {
+  /**
+   * @param {SharedArrayBuffer|number} bufferOrCapacity - Existing snapshot buffer, or entity
+   *   capacity for a new one
+   */
+  constructor(bufferOrCapacity = 4096) {
+    if (typeof bufferOrCapacity === 'number') {
+      bufferOrCapacity = new SharedArrayBuffer(SharedSnapshot.byteLength(bufferOrCapacity));
+    }
+    const capacity = SharedSnapshot.capacityOf(bufferOrCapacity.byteLength);
+    let offset = 0;
+    this.buffer = bufferOrCapacity;
+    this.capacity = capacity;
+    this.header = new Int32Array(this.buffer, offset, HEADER_INTS); offset += HEADER_INTS * 4;
+    this.handles = new Uint32Array(this.buffer, offset, capacity); offset += capacity * 4;
+    this.xs = new Uint16Array(this.buffer, offset, capacity); offset += capacity * 2;
+    this.ys = new Uint16Array(this.buffer, offset, capacity); offset += capacity * 2;
+    this.kinds = new Uint8Array(this.buffer, offset, capacity); offset += capacity;
+    this.message = new Uint8Array(this.buffer, offset, MESSAGE_BYTES);
+    this.lastGood = null;
+    this.mobHandles = new WeakMap(); // Writer only: Mob -> handle, dropped with the mob
+    this.nextMobHandle = 1;
+  }
+
+  static byteLength(capacity) {
+    return HEADER_INTS * 4 + capacity * 9 + MESSAGE_BYTES;
+  }
+
+  static capacityOf(byteLength) {
+    return Math.floor((byteLength - HEADER_INTS * 4 - MESSAGE_BYTES) / 9);
+  }
+
+  get width() {
+    return Atomics.load(this.header, WIDTH);
+  }
+
+  get height() {
+    return Atomics.load(this.header, HEIGHT);
+  }
+
+  /**
+   * Writer: publish a world's current entities
+   * @param {World} world - World to copy
+   * @param {Function} handleOf - Maps a player to its numeric handle
+   */
+  write(world, handleOf) {
+    const header = this.header;
+    Atomics.add(header, SEQ, 1); // Odd: write in progress
+
+    let count = 0;
+    for (const player of world.players.values()) {
+      if (count === this.capacity) break;
+      this.kinds[count] = KIND_PLAYER;
+      this.handles[count] = handleOf(player);
+      this.xs[count] = player.x;
+      this.ys[count] = player.y;
+      count++;
+    }
+    for (const mob of world.mobs.values()) {
+      if (count === this.capacity) break;
+      this.kinds[count] = mob.isHunter ? KIND_HUNTER : KIND_MOB;
+      this.handles[count] = this.mobHandleOf(mob);
+      this.xs[count] = mob.x;
+      this.ys[count] = mob.y;
+      count++;
+    }
+
+    const msg = Buffer.from(world.lastKillMessage || '').subarray(0, MESSAGE_BYTES);
+    this.message.set(msg);
+    header[COUNT] = count;
+    header[TICKS] = world.ticks;
+    header[MSG_LEN] = msg.length;
+    header[WIDTH] = world.width;
+    header[HEIGHT] = world.height;
+
+    Atomics.add(header, SEQ, 1); // Even: consistent again
+  }
+
+  mobHandleOf(mob) {
+    let handle = this.mobHandles.get(mob);
+    if (!handle) {
+      handle = this.nextMobHandle;
+      this.nextMobHandle = (this.nextMobHandle % 0xFFFFFFFF) + 1;
+      this.mobHandles.set(mob, handle);
+    }
+    return handle;
+  }
+
+  /**
+   * Reader: copy out a consistent snapshot
+   * @returns {Object|null} - {seq, ticks, width, height, message, entities: [{kind, handle, x, y}]},
+   *   the last good copy if the writer kept interrupting, or null before the first publish
+   */
+  read() {
+    const header = this.header;
+    for (let attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+      const seq = Atomics.load(header, SEQ);
+      if (seq & 1) {
+        continue;
+      }
+      if (this.lastGood && this.lastGood.seq === seq) {
+        return this.lastGood;
+      }
+
+      const count = Math.min(header[COUNT], this.capacity);
+      const entities = new Array(count);
+      for (let i = 0; i < count; i++) {
+        entities[i] = { kind: this.kinds[i], handle: this.handles[i], x: this.xs[i], y: this.ys[i] };
+      }
+      const snapshot = {
+        seq,
+        ticks: header[TICKS],
+        width: header[WIDTH],
+        height: header[HEIGHT],
+        message: Buffer.from(this.message.subarray(0, Math.min(header[MSG_LEN], MESSAGE_BYTES))).toString(),
+        entities
+      };
+
+      if (Atomics.load(header, SEQ) === seq) {
+        if (seq === 0) {
+          return null;
+        }
+        this.lastGood = snapshot;
+        return snapshot;
+      }
+    }
+    return this.lastGood;
+  }
+}
+
+SharedSnapshot.KIND_PLAYER = KIND_PLAYER;
+SharedSnapshot.KIND_MOB = KIND_MOB;
+SharedSnapshot.KIND_HUNTER = KIND_HUNTER;
+
+module.exports = SharedSnapshot;
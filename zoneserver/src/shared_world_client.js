@@ -0,0 +1,189 @@
+/**
+ * Shared World Client
+ *
+ * Used by an IO worker to talk to the simulation thread. State requests
+ * are answered locally from the seqlocked SharedSnapshot; joins, moves
+ * and leaves go to the simulation over an SPSC ring and their replies
+ * come back on a second ring.
+ *
+ * Implements the ArenaManager interface TcpServer uses for remote worlds,
+ * with the whole shared world as arena 0.
+ */
+
+const World = require('./world');
+const SharedSnapshot = require('./shared_snapshot');
+
+// Ring message opcodes. Requests: [Op] [RequestId u32] [Body...], replies echo Op and RequestId.
+const OPS = {
+  JOIN: 1,  // [NameLen] [Name] -> [Handle u32] [X u16] [Y u16] [Health] [IdLen] [Id]
+  MOVE: 2,  // [Handle u32] [Dir] -> [Ok] [X u16] [Y u16] [Health] [Collision] [MsgLen] [Msg]
+  LEAVE: 3  // [Handle u32] -> [Removed]
+};
+
+const ARENA_ID = 0;
+
+class SharedWorldClient {
+  /**
+   * @param {SharedSnapshot} snapshot - Snapshot published by the simulation
+   * @param {SpscRing} toSim - Ring this thread produces commands into
+   * @param {SpscRing} fromSim - Ring the simulation produces replies into
+   * @param {Function} kick - Wakes the simulation thread
+   */
+  constructor(snapshot, toSim, fromSim, kick) {
+    this.snapshot = snapshot;
+    this.toSim = toSim;
+    this.fromSim = fromSim;
+    this.kick = kick;
+    this.pending = new Map(); // requestId -> resolve
+    this.backlog = [];        // Commands waiting for ring space
+    this.handles = new Map(); // playerId -> handle
+    this.nextRequestId = 1;
+    this.retryTimer = null;
+  }
+
+  get width() {
+    return this.snapshot.width;
+  }
+
+  get height() {
+    return this.snapshot.height;
+  }
+
+  /**
+   * Queue a command for the simulation
+   * @returns {Promise<Buffer>} - Reply body after the opcode and request id
+   */
+  request(op, body) {
+    const requestId = this.nextRequestId++ >>> 0;
+    const msg = Buffer.alloc(5 + body.length);
+    msg.writeUInt8(op, 0);
+    msg.writeUInt32LE(requestId, 1);
+    body.copy(msg, 5);
+    return new Promise((resolve) => {
+      this.pending.set(requestId, resolve);
+      this.backlog.push(msg);
+      this.flush();
+    });
+  }
+
+  flush() {
+    let pushed = false;
+    while (this.backlog.length > 0 && this.toSim.push(this.backlog[0])) {
+      this.backlog.shift();
+      pushed = true;
+    }
+    if (pushed && this.toSim.claimKick()) {
+      this.kick();
+    }
+    if (this.backlog.length > 0 && !this.retryTimer) {
+      // Ring full: the simulation is behind, try again shortly
+      this.retryTimer = setTimeout(() => {
+        this.retryTimer = null;
+        this.flush();
+      }, 1);
+    }
+  }
+
+  /**
+   * Resolve every reply the simulation has published
+   */
+  drainReplies() {
+    this.fromSim.clearKick();
+    let msg;
+    while ((msg = this.fromSim.pop()) !== null) {
+      const requestId = msg.readUInt32LE(1);
+      const resolve = this.pending.get(requestId);
+      if (resolve) {
+        this.pending.delete(requestId);
+        resolve(msg.subarray(5));
+      }
+    }
+  }
+
+  async join(name) {
+    const nameBuf = Buffer.from(name).subarray(0, 255);
+    const reply = await this.request(OPS.JOIN, Buffer.concat([Buffer.from([nameBuf.length]), nameBuf]));
+    const handle = reply.readUInt32LE(0);
+    const idLen = reply[9];
+    const player = {
+      id: reply.subarray(10, 10 + idLen).toString(),
+      name,
+      x: reply.readUInt16LE(4),
+      y: reply.readUInt16LE(6),
+      health: reply[8]
+    };
+    this.handles.set(player.id, handle);
+    return { arenaId: ARENA_ID, player };
+  }
+
+  async move(arenaId, playerId, direction) {
+    const handle = this.handles.get(playerId);
+    if (!handle || !direction) {
+      return null;
+    }
+    const body = Buffer.alloc(5);
+    body.writeUInt32LE(handle, 0);
+    body.writeUInt8(direction.charCodeAt(0), 4);
+    const reply = await this.request(OPS.MOVE, body);
+    if (!reply[0]) {
+      return null;
+    }
+    return {
+      x: reply.readUInt16LE(1),
+      y: reply.readUInt16LE(3),
+      health: reply[5],
+      collision: reply[6] === 1,
+      message: reply.subarray(8, 8 + reply[7]).toString()
+    };
+  }
+
+  async leave(arenaId, playerId) {
+    const handle = this.handles.get(playerId);
+    if (!handle) {
+      return false;
+    }
+    this.handles.delete(playerId);
+    const body = Buffer.alloc(4);
+    body.writeUInt32LE(handle, 0);
+    return (await this.request(OPS.LEAVE, body))[0] === 1;
+  }
+
+  /**
+   * Build a state object from the shared snapshot, without involving the simulation
+   * @returns {Promise<Object|null>} - Same shape TcpServer gets from World.getState
+   */
+  async getState(arenaId, playerId = null, viewport = null) {
+    const snap = this.snapshot.read();
+    if (!snap) {
+      return null;
+    }
+
+    const myHandle = playerId ? this.handles.get(playerId) || 0 : 0;
+    const isMe = (e) => myHandle !== 0 && e.kind === SharedSnapshot.KIND_PLAYER && e.handle === myHandle;
+    let entities = snap.entities;
+    const me = entities.find(isMe);
+    if (me && viewport) {
+      const rect = World.prototype.getViewportRect.call(snap, me.x, me.y, viewport.width, viewport.height);
+      entities = entities.filter(e => e.x >= rect.x0 && e.x <= rect.x1 && e.y >= rect.y0 && e.y <= rect.y1);
+    }
+
+    return {
+      width: snap.width,
+      height: snap.height,
+      ticks: snap.ticks,
+      lastKillMessage: snap.message,
+      players: entities.map(e => ({
+        // Player and mob handles overlap, so mob ids get their own prefix
+        id: isMe(e) ? playerId : (e.kind === SharedSnapshot.KIND_PLAYER ? `#${e.handle}` : `#m${e.handle}`),
+        type: e.kind === SharedSnapshot.KIND_PLAYER ? 'player' : 'mob',
+        isHunter: e.kind === SharedSnapshot.KIND_HUNTER,
+        x: e.x,
+        y: e.y
+      }))
+    };
+  }
+}
+
+SharedWorldClient.OPS = OPS;
+
+module.exports = SharedWorldClient;
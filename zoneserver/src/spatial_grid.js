@@ -0,0 +1,150 @@
+/**
+ * Spatial Grid
+ *
+ * Buckets entities by fixed-size cells (chunks) so area and position
+ * queries only visit the cells that overlap the requested area.
+ * Cells are allocated on first use and dropped when they empty, so
+ * memory scales with the occupied area rather than the world size.
+ */
+
+class SpatialGrid {
+  /**
+   * @param {number} cellSize - Width/height of a cell in world units
+   */
+  constructor(cellSize = 8) {
+    this.cellSize = cellSize;
+    this.cells = new Map();       // cellKey -> Set of entities
+    this.entityCells = new Map(); // entity -> cellKey
+  }
+
+  cellKey(cx, cy) {
+    return cx * 65536 + cy;
+  }
+
+  keyFor(x, y) {
+    return this.cellKey(Math.floor(x / this.cellSize), Math.floor(y / this.cellSize));
+  }
+
+  /**
+   * Add an entity at its current position
+   * @param {Object} entity - Entity with x/y
+   */
+  insert(entity) {
+    if (this.entityCells.has(entity)) {
+      this.update(entity);
+      return;
+    }
+    const key = this.keyFor(entity.x, entity.y);
+    let cell = this.cells.get(key);
+    if (!cell) {
+      cell = new Set();
+      this.cells.set(key, cell);
+    }
+    cell.add(entity);
+    this.entityCells.set(entity, key);
+  }
+
+  /**
+   * Remove an entity from the grid
+   * @param {Object} entity - Entity to remove
+   * @returns {boolean} - True if the entity was indexed
+   */
+  remove(entity) {
+    const key = this.entityCells.get(entity);
+    if (key === undefined) {
+      return false;
+    }
+    const cell = this.cells.get(key);
+    cell.delete(entity);
+    if (cell.size === 0) {
+      this.cells.delete(key);
+    }
+    this.entityCells.delete(entity);
+    return true;
+  }
+
+  /**
+   * Re-bucket an entity after its position changed
+   * @param {Object} entity - Entity with updated x/y
+   */
+  update(entity) {
+    const oldKey = this.entityCells.get(entity);
+    if (oldKey === undefined) {
+      return;
+    }
+    if (oldKey !== this.keyFor(entity.x, entity.y)) {
+      this.remove(entity);
+      this.insert(entity);
+    }
+  }
+
+  /**
+   * Find entities inside an inclusive rectangle
+   * @param {number} x0 - Left
+   * @param {number} y0 - Top
+   * @param {number} x1 - Right (inclusive)
+   * @param {number} y1 - Bottom (inclusive)
+   * @returns {Array} - Matching entities
+   */
+  queryRect(x0, y0, x1, y1) {
+    const result = [];
+    const cx0 = Math.floor(x0 / this.cellSize);
+    const cy0 = Math.floor(y0 / this.cellSize);
+    const cx1 = Math.floor(x1 / this.cellSize);
+    const cy1 = Math.floor(y1 / this.cellSize);
+
+    for (let cx = cx0; cx <= cx1; cx++) {
+      for (let cy = cy0; cy <= cy1; cy++) {
+        const cell = this.cells.get(this.cellKey(cx, cy));
+        if (!cell) {
+          continue;
+        }
+        for (const entity of cell) {
+          if (entity.x >= x0 && entity.x <= x1 && entity.y >= y0 && entity.y <= y1) {
+            result.push(entity);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Find entities at an exact position
+   * @param {number} x - X coordinate
+   * @param {number} y - Y coordinate
+   * @returns {Array} - Entities at (x, y)
+   */
+  getAt(x, y) {
+    const cell = this.cells.get(this.keyFor(x, y));
+    if (!cell) {
+      return [];
+    }
+    const result = [];
+    for (const entity of cell) {
+      if (entity.x === x && entity.y === y) {
+        result.push(entity);
+      }
+    }
+    return result;
+  }
+
+  clear() {
+    this.cells.clear();
+    this.entityCells.clear();
+  }
+
+  get size() {
+    return this.entityCells.size;
+  }
+
+  /**
+   * Number of allocated cells
+   * @returns {number}
+   */
+  get cellCount() {
+    return this.cells.size;
+  }
+}
+
+module.exports = SpatialGrid;
@@ -0,0 +1,108 @@
+/**
+ * SPSC Ring
+ *
+ * Lock-free single-producer/single-consumer message queue over a
+ * SharedArrayBuffer, for passing commands between two threads. Each
+ * message is a 2-byte length followed by its bytes. The producer only
+ * writes `head`, the consumer only writes `tail`.
+ *
+ * A shared kick flag lets the producer wake a consumer that is not
+ * polling: it posts one wake-up message per batch instead of per push.
+ */
+
+const HEAD = 0;
+const TAIL = 1;
+const KICK = 2;
+const HEADER_BYTES = 16;
+
+class SpscRing {
+  /**
+   * @param {SharedArrayBuffer|number} bufferOrCapacity - Existing ring buffer, or data capacity
+   *   in bytes (rounded up to a power of two) for a new one
+   */
+  constructor(bufferOrCapacity = 65536) {
+    if (typeof bufferOrCapacity === 'number') {
+      let capacity = 64;
+      while (capacity < bufferOrCapacity) {
+        capacity *= 2;
+      }
+      bufferOrCapacity = new SharedArrayBuffer(HEADER_BYTES + capacity);
+    }
+    this.buffer = bufferOrCapacity;
+    this.header = new Int32Array(this.buffer, 0, HEADER_BYTES / 4);
+    this.data = new Uint8Array(this.buffer, HEADER_BYTES);
+    this.mask = this.data.length - 1;
+  }
+
+  get capacity() {
+    return this.data.length;
+  }
+
+  /**
+   * Producer: append a message
+   * @param {Uint8Array} bytes - Message (at most 65535 bytes)
+   * @returns {boolean} - False if the ring is full
+   */
+  push(bytes) {
+    const head = this.header[HEAD] >>> 0; // Only this thread writes head
+    const tail = Atomics.load(this.header, TAIL) >>> 0;
+    const used = (head - tail) >>> 0;
+    if (bytes.length > 0xFFFF || this.capacity - used < 2 + bytes.length) {
+      return false;
+    }
+
+    const data = this.data;
+    const mask = this.mask;
+    data[head & mask] = bytes.length & 0xFF;
+    data[(head + 1) & mask] = bytes.length >> 8;
+    for (let i = 0; i < bytes.length; i++) {
+      data[(head + 2 + i) & mask] = bytes[i];
+    }
+    // Publish only after the payload is written
+    Atomics.store(this.header, HEAD, (head + 2 + bytes.length) | 0);
+    return true;
+  }
+
+  /**
+   * Consumer: take the oldest message
+   * @returns {Buffer|null} - Message copy, null if empty
+   */
+  pop() {
+    const tail = this.header[TAIL] >>> 0; // Only this thread writes tail
+    const head = Atomics.load(this.header, HEAD) >>> 0;
+    if (head === tail) {
+      return null;
+    }
+
+    const data = this.data;
+    const mask = this.mask;
+    const len = data[tail & mask] | (data[(tail + 1) & mask] << 8);
+    const out = Buffer.allocUnsafe(len);
+    for (let i = 0; i < len; i++) {
+      out[i] = data[(tail + 2 + i) & mask];
+    }
+    Atomics.store(this.header, TAIL, (tail + 2 + len) | 0);
+    return out;
+  }
+
+  isEmpty() {
+    return (Atomics.load(this.header, HEAD) >>> 0) === (Atomics.load(this.header, TAIL) >>> 0);
+  }
+
+  /**
+   * Producer: claim the wake-up for this batch
+   * @returns {boolean} - True if the caller should notify the consumer
+   */
+  claimKick() {
+    return Atomics.exchange(this.header, KICK, 1) === 0;
+  }
+
+  /**
+   * Consumer: re-arm wake-ups before draining
+   */
+  clearKick() {
+    Atomics.store(this.header, KICK, 0);
+  }
+}
+
+module.exports = SpscRing;
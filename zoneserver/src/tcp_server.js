@@ -1,23 +1,172 @@
 const net = require('net');
-const Player = require('./player');
-const CombatResolver = require('./combat');
+const crypto = require('crypto');
+const GameRules = require('./game_rules');
+const ClientOutbox = require('./client_outbox');
+
+// Protocol versions: 1 = 8-bit coordinates, 2 = 16-bit little-endian coordinates,
+// 3 = version 2 plus bit-packed 0x07 state replies, 4 = capability join (0x06),
+// 5 = single round-trip connect (0x08), 6 = ping/pong (0x0A), 7 = sequenced moves (0x0B),
+// 8 = batched moves (0x0C)
+const PROTOCOL_VERSION = 8;
+
+// Capability bits exchanged in a 0x06 join. The server grants the subset it supports.
+const CAPS = {
+    WIDE_COORDS: 0x01, // 16-bit little-endian coordinates
+    PACKED: 0x02,      // Bit-packed 0x07 state replies
+    DELTA: 0x04,       // Packed records may repeat the previous reply (needs PACKED)
+    PUSH: 0x08,        // State pushed without polling (reserved, not offered yet)
+    NUMERIC_IDS: 0x10, // State records carry a 16-bit id, stable while the entity stays in view
+    FRAMED: 0x20,      // Every reply carries [LenLo] [LenHi] after its type byte
+    RESUME: 0x40,      // 0x08 replies carry a token for resuming with 0x09 (main world only)
+    UDP: 0x80          // 0x08 replies carry the UDP snapshot port (only while a UdpServer is attached)
+};
+const SERVER_CAPS = CAPS.WIDE_COORDS | CAPS.PACKED | CAPS.DELTA | CAPS.NUMERIC_IDS | CAPS.FRAMED | CAPS.RESUME;
+
+const RESUME_TOKEN_BYTES = 8;
+
+// Replies that always carry a length after the type, framed or not
+const LENGTH_PREFIXED = new Set([0x07, 0x08]);
+
+/**
+ * Capabilities implied by a 0x05 hello version, for clients that never send 0x06
+ * @returns {number}
+ */
+function capsForVersion(version) {
+    if (version >= 3) return CAPS.WIDE_COORDS | CAPS.PACKED | CAPS.DELTA;
+    if (version === 2) return CAPS.WIDE_COORDS;
+    return 0;
+}
+
+// Packed entity type codes, indexed by the 2-bit field
+const PACKED_TYPES = ['M', 'P', 'H', 'E'];
+const PACKED_RUN_BITS = 4; // Run length field: repeats 1..16 records
+
+/**
+ * MSB-first bit writer for packed state records
+ */
+class BitWriter {
+    constructor() {
+        this.bytes = [];
+        this.acc = 0;
+        this.used = 0;
+    }
+
+    write(value, bits) {
+        for (let i = bits - 1; i >= 0; i--) {
+            this.acc = (this.acc << 1) | ((value >> i) & 1);
+            if (++this.used === 8) {
+                this.bytes.push(this.acc);
+                this.acc = 0;
+                this.used = 0;
+            }
+        }
+    }
+
+    toBuffer() {
+        const bytes = this.used ? [...this.bytes, this.acc << (8 - this.used)] : this.bytes;
+        return Buffer.from(bytes);
+    }
+}
+
+/**
+ * Encode an unsigned LEB128 varint
+ * @returns {Buffer}
+ */
+function encodeVarint(value) {
+    const bytes = [];
+    do {
+        let b = value & 0x7F;
+        value >>>= 7;
+        if (value) b |= 0x80;
+        bytes.push(b);
+    } while (value);
+    return Buffer.from(bytes);
+}
+
+/**
+ * Bits needed to hold every value up to max
+ * @returns {number}
+ */
+function bitsFor(max) {
+    return max > 0 ? 32 - Math.clz32(max) : 0;
+}
+
+/**
+ * Fold one move of a batch into the batch's reply: any fight sets the
+ * collision flag and the last fight's message is the one reported
+ * @param {Object} batch - {collision, message}, updated in place
+ * @param {Object|null} result - GameRules.movePlayer result, null if not applied
+ */
+function mergeMove(batch, result) {
+    if (!result) return;
+    if (result.collision) batch.collision = true;
+    if (result.message) batch.message = result.message;
+}
 
 /**
  * TCP Server for KillZone
  * Handles binary connections for low-latency gameplay
  */
 class TcpServer {
-    constructor(world, port) {
+    /**
+     * @param {World} world - Shared world
+     * @param {number} port - TCP port to listen on
+     * @param {Object} options - Outbox limits (see ClientOutbox.DEFAULT_LIMITS), plus
+     *   `arenas`: an ArenaManager (or SharedWorldClient); when set, joins go there instead of `world`
+     *   `reusePort`: listen with SO_REUSEPORT so several threads can share the port
+     *   `resumeGraceMs`: how long a dropped connection's session can be resumed
+     *   `tickHz`: world tick rate reported in pongs, 0 when the world ticks per state request
+     */
+    constructor(world, port, options = {}) {
+        const { arenas = null, reusePort = false, resumeGraceMs = 30000, tickHz = 0, ...limits } = options;
         this.world = world;
+        this.arenas = arenas;
         this.port = port;
+        this.reusePort = reusePort;
+        this.resumeGraceMs = resumeGraceMs;
+        this.tickHz = tickHz;
+        this.udpPort = 0; // Set by an attached UdpServer once it listens; 0 = no UDP channel
+        this.sessions = new Map(); // resume token (hex) -> {player, codec, timer}
+        this.outboxLimits = { ...ClientOutbox.DEFAULT_LIMITS, ...limits };
         this.server = net.createServer(this.handleConnection.bind(this));
         this.clients = new Set();
+        this.sweepTimer = null;
     }
 
-    start() {
-        this.server.listen(this.port, () => {
+    /**
+     * @param {Object} handle - Optional listening socket handle to accept on instead of binding the port
+     */
+    start(handle = null) {
+        const listenOptions = this.reusePort ? { port: this.port, reusePort: true } : { port: this.port };
+        this.server.listen(handle || listenOptions, () => {
             console.log(`KillZone TCP Server running on port ${this.port}`);
         });
+
+        // Clients that stop reading may also stop sending, so check backlogs on a timer too
+        this.sweepTimer = setInterval(() => this.sweepSlowClients(), 1000);
+        this.sweepTimer.unref();
+    }
+
+    stop(callback) {
+        if (this.sweepTimer) {
+            clearInterval(this.sweepTimer);
+            this.sweepTimer = null;
+        }
+        for (const socket of this.clients) {
+            socket.destroy();
+        }
+        for (const session of this.sessions.values()) {
+            clearTimeout(session.timer);
+        }
+        this.sessions.clear();
+        this.server.close(callback);
+    }
+
+    sweepSlowClients() {
+        const now = Date.now();
+        for (const socket of this.clients) {
+            socket.outbox.flush(now);
+        }
     }
 
     handleConnection(socket) {
@@ -25,200 +174,591 @@ class TcpServer {
         this.clients.add(socket);
 
         socket.player = null; // Associated player object
+        socket.viewport = null; // Declared client viewport {width, height}, null = whole world
+        socket.codec = newCodec(0); // Negotiated encoding
+        socket.connectVersion = 1; // Version settled by a 0x08 connect
+        socket.resumeToken = null; // Issued in the 0x08 reply when RESUME is granted
+        socket.rttMs = 0; // Smoothed round-trip time reported in the client's pings (0 = unknown)
+        socket.lastTicks = 0; // Ticks of the last state sent
+        socket.rxBuffer = Buffer.alloc(0); // Unparsed inbound bytes
+        socket.arenaId = null; // Arena holding the player (arena mode)
+        socket.queue = Promise.resolve(); // Serialises async arena requests
+        socket.outbox = new ClientOutbox(socket, this.outboxLimits);
 
         socket.on('data', (data) => this.handleData(socket, data));
         socket.on('close', () => this.handleClose(socket));
         socket.on('error', (err) => console.error(`Socket error: ${err.message}`));
     }
 
+    /**
+     * Length of the inbound packet at the start of buf
+     * @param {Buffer} buf - Buffered bytes, starting at a packet type
+     * @returns {number} - Packet length, 0 if more bytes are needed, -1 if unknown
+     */
+    packetLength(buf) {
+        switch (buf[0]) {
+            case 0x01: return buf.length < 2 ? 0 : 2 + buf[1]; // Join: [NameLen] [Name]
+            case 0x02: return 2;                               // Move: [Dir]
+            case 0x03: return 1;                               // Get State
+            case 0x04: return 3;                               // Viewport: [W] [H]
+            case 0x05: return 2;                               // Hello: [Version]
+            case 0x06: return buf.length < 4 ? 0 : 4 + buf[3]; // Join: [CapsLo] [CapsHi] [NameLen] [Name]
+            case 0x08: return buf.length < 7 ? 0 : 7 + buf[6]; // Connect: [Ver] [Caps x2] [W] [H] [NameLen] [Name]
+            case 0x09: return buf.length < 11 ? 0 : 11 + buf[10]; // Resume: [Ver] [Caps x2] [W] [H] [Ticks x2] [Count x2] [TokLen] [Tok]
+            case 0x0A: return 5;                               // Ping: [Stamp x2] [Rtt x2]
+            case 0x0B: return 3;                               // Sequenced move: [Seq] [Dir]
+            case 0x0C: return buf.length < 3 ? 0 : 3 + buf[2]; // Batched moves: [Seq] [Count] [Dir...]
+            default: return -1;
+        }
+    }
+
     handleData(socket, data) {
-        const packetType = data[0];
+        // TCP may split or coalesce packets, so parse from a per-socket buffer
+        socket.rxBuffer = socket.rxBuffer.length ? Buffer.concat([socket.rxBuffer, data]) : data;
+
+        while (socket.rxBuffer.length > 0 && !socket.destroyed) {
+            const len = this.packetLength(socket.rxBuffer);
+            if (len < 0) {
+                console.log(`Unknown packet type: ${socket.rxBuffer[0]}`);
+                socket.rxBuffer = Buffer.alloc(0);
+                return;
+            }
+            if (len === 0 || socket.rxBuffer.length < len) {
+                return;
+            }
+            const packet = socket.rxBuffer.subarray(0, len);
+            socket.rxBuffer = socket.rxBuffer.subarray(len);
+            this.handlePacket(socket, packet[0], packet.subarray(1));
+        }
+    }
 
+    handlePacket(socket, packetType, data) {
+        if (this.arenas) {
+            // Arena requests resolve asynchronously; chain them so replies keep request order
+            socket.queue = socket.queue
+                .then(() => this.dispatchPacket(socket, packetType, data))
+                .catch((e) => console.error(`Error handling TCP data: ${e.message}`));
+            return;
+        }
         try {
-            switch (packetType) {
-                case 0x01: // Join
-                    this.handleJoin(socket, data.slice(1));
-                    break;
-                case 0x02: // Move
-                    this.handleMove(socket, data.slice(1));
-                    break;
-                case 0x03: // Get State
-                    this.handleGetState(socket);
-                    break;
-                default:
-                    console.log(`Unknown packet type: ${packetType}`);
-            }
+            this.dispatchPacket(socket, packetType, data);
         } catch (e) {
             console.error(`Error handling TCP data: ${e.message}`);
         }
     }
 
-    handleJoin(socket, data) {
-        if (data.length < 1) return;
+    dispatchPacket(socket, packetType, data) {
+        switch (packetType) {
+            case 0x01: // Join
+                return this.arenas ? this.handleArenaJoin(socket, data) : this.handleJoin(socket, data);
+            case 0x02: // Move
+                return this.arenas ? this.handleArenaMove(socket, data) : this.handleMove(socket, data);
+            case 0x03: // Get State
+                return this.arenas ? this.handleArenaGetState(socket) : this.handleGetState(socket);
+            case 0x04: // Set Viewport
+                return this.handleSetViewport(socket, data);
+            case 0x05: // Hello
+                return this.handleHello(socket, data);
+            case 0x06: // Join with capabilities
+                this.negotiateCaps(socket, data.readUInt16LE(0));
+                return this.arenas ? this.handleArenaJoin(socket, data.subarray(2), true)
+                    : this.handleJoin(socket, data.subarray(2), true);
+            case 0x08: // Connect
+                return this.arenas ? this.handleArenaConnect(socket, data) : this.handleConnect(socket, data);
+            case 0x09: // Resume
+                return this.handleResume(socket, data);
+            case 0x0A: // Ping
+                return this.handlePing(socket, data);
+            case 0x0B: // Sequenced move
+                return this.arenas ? this.handleArenaMove(socket, data.subarray(1), data[0])
+                    : this.handleMove(socket, data.subarray(1), data[0]);
+            case 0x0C: // Batched moves
+                return this.arenas ? this.handleArenaMoveBatch(socket, data) : this.handleMoveBatch(socket, data);
+        }
+    }
+
+    /**
+     * Bytes per coordinate for this client
+     * @returns {number} - 1 or 2
+     */
+    coordSize(socket) {
+        return socket.codec.caps & CAPS.WIDE_COORDS ? 2 : 1;
+    }
+
+    /**
+     * Write a coordinate in the client's protocol width
+     * @returns {number} - Offset after the coordinate
+     */
+    writeCoord(socket, buf, value, offset) {
+        if (socket.codec.caps & CAPS.WIDE_COORDS) {
+            return buf.writeUInt16LE(Math.floor(value), offset);
+        }
+        return buf.writeUInt8(Math.floor(value), offset);
+    }
+
+    handleHello(socket, data) {
+        // Hello: 0x05 [Version] -> 0x05 [Version] [WidthLo] [WidthHi] [HeightLo] [HeightHi]
+        const version = Math.max(1, Math.min(data[0], PROTOCOL_VERSION));
+        const world = this.arenas || this.world;
+        socket.codec.caps = capsForVersion(version);
+
+        const resp = Buffer.alloc(6);
+        resp.writeUInt8(0x05, 0);
+        resp.writeUInt8(version, 1);
+        resp.writeUInt16LE(world.width, 2);
+        resp.writeUInt16LE(world.height, 4);
+        socket.outbox.send(this.frame(socket, resp));
+    }
+
+    /**
+     * Ping: 0x0A [StampLo] [StampHi] [RttLo] [RttHi]
+     * -> 0x0A [StampLo] [StampHi] [TicksLo] [TicksHi] [TickHz] [TimeMs u32 LE]
+     * The stamp is the client's clock, echoed so it can time the round trip;
+     * Rtt is its smoothed result in ms so far. Ticks and TickHz let it
+     * estimate the server tick between pongs.
+     */
+    handlePing(socket, data) {
+        socket.rttMs = data.readUInt16LE(2);
+        const ticks = this.arenas ? socket.lastTicks : this.world.ticks;
+
+        const resp = Buffer.alloc(10);
+        resp.writeUInt8(0x0A, 0);
+        data.copy(resp, 1, 0, 2);
+        resp.writeUInt16LE(ticks % 65536, 3);
+        resp.writeUInt8(this.tickHz, 5);
+        resp.writeUInt32LE(Date.now() % 0x100000000, 6);
+        socket.outbox.send(this.frame(socket, resp));
+    }
+
+    /**
+     * Per-connection metrics for /api/metrics
+     * @returns {Object}
+     */
+    getStats() {
+        const connections = [...this.clients].map(socket => ({
+            player: socket.player ? socket.player.name : null,
+            address: socket.remoteAddress,
+            protocolVersion: socket.connectVersion,
+            caps: socket.codec.caps,
+            rttMs: socket.rttMs,
+            ...socket.outbox.getStats()
+        }));
+        const measured = connections.filter(c => c.rttMs > 0);
+        return {
+            connections,
+            resumableSessions: this.sessions.size,
+            meanRttMs: measured.length ? Math.round(measured.reduce((sum, c) => sum + c.rttMs, 0) / measured.length) : 0
+        };
+    }
+
+    /**
+     * Settle the encoding for this connection from the client's capability bits
+     * @param {number} requested - Capabilities the client can decode
+     * @returns {number} - Capabilities granted
+     */
+    negotiateCaps(socket, requested) {
+        let caps = requested & SERVER_CAPS;
+        if (!(caps & CAPS.PACKED)) {
+            caps &= ~CAPS.DELTA;
+        }
+        if (this.arenas) {
+            caps &= ~CAPS.RESUME; // Arena players leave their worker as soon as the socket closes
+        }
+        if ((requested & CAPS.UDP) && this.udpPort && !this.arenas) {
+            caps |= CAPS.UDP;
+        }
+        socket.codec = newCodec(caps);
+        return caps;
+    }
+
+    /**
+     * Read the name from a join packet
+     * @returns {string|null}
+     */
+    parseJoinName(data) {
+        if (data.length < 1) return null;
         const nameLen = data[0];
-        if (data.length < 1 + nameLen) return;
+        if (data.length < 1 + nameLen) return null;
+        return data.slice(1, 1 + nameLen).toString();
+    }
 
-        const name = data.slice(1, 1 + nameLen).toString();
+    handleJoin(socket, data, withCaps = false) {
+        const name = this.parseJoinName(data);
+        if (name === null) return;
+        this.sendJoin(socket, this.joinWorld(socket, name), withCaps);
+    }
+
+    async handleArenaJoin(socket, data, withCaps = false) {
+        const name = this.parseJoinName(data);
+        if (name === null) return;
+        this.sendJoin(socket, await this.joinArena(socket, name), withCaps);
+    }
+
+    /**
+     * Add (or re-attach) the socket's player in the main world
+     * @returns {Player}
+     */
+    joinWorld(socket, name) {
         console.log(`TCP Join Request: ${name}`);
+        const { player, isReconnect } = GameRules.joinPlayer(this.world, name);
+        console.log(isReconnect ? `  🔄 TCP Rejoin: ${name}` : `  👤 TCP Join: ${name}`);
+        socket.player = player;
+        return player;
+    }
 
-        // Check if previously disconnected
-        const disconnectedPlayer = this.world.getDisconnectedPlayer(name);
-        let player;
-
-        if (disconnectedPlayer) {
-            player = disconnectedPlayer;
-            player.status = 'alive';
-            player.health = 100;
-
-            // New spawn pos
-            let x, y;
-            let attempts = 0;
-            do {
-                x = Math.floor(Math.random() * this.world.width);
-                y = Math.floor(Math.random() * this.world.height);
-                attempts++;
-            } while (this.world.getPlayerAtPosition(x, y) !== null && attempts < 10);
-
-            player.setPosition(x, y);
-            this.world.removeDisconnectedPlayer(name);
-            this.world.addPlayer(player);
-            this.world.setRejoinMessage(name);
-            console.log(`  🔄 TCP Rejoin: ${name}`);
-        } else {
-            const playerId = `player_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`;
-            let x, y;
-            let attempts = 0;
-            do {
-                x = Math.floor(Math.random() * this.world.width);
-                y = Math.floor(Math.random() * this.world.height);
-                attempts++;
-            } while (this.world.getPlayerAtPosition(x, y) !== null && attempts < 10);
+    /**
+     * Place the socket's player in an arena, leaving any previous one
+     * @returns {Promise<Object>} - The player
+     */
+    async joinArena(socket, name) {
+        if (socket.arenaId !== null) {
+            await this.arenas.leave(socket.arenaId, socket.player.id);
+        }
+        const { arenaId, player } = await this.arenas.join(name);
+        console.log(`  👤 TCP Join: ${name} (arena ${arenaId})`);
+        socket.arenaId = arenaId;
+        socket.player = player;
+        return player;
+    }
 
-            player = new Player(playerId, name, x, y);
-            this.world.addPlayer(player);
-            this.world.setJoinMessage(name);
-            console.log(`  👤 TCP Join: ${name}`);
+    /**
+     * Settle version, caps and viewport from a 0x08 connect
+     * @returns {string|null} - Name to join as
+     */
+    parseConnect(socket, data) {
+        // Connect: 0x08 [Version] [CapsLo] [CapsHi] [ViewW] [ViewH] [NameLen] [Name]
+        socket.connectVersion = Math.max(1, Math.min(data[0], PROTOCOL_VERSION));
+        this.negotiateCaps(socket, data.readUInt16LE(1));
+        this.handleSetViewport(socket, data.subarray(3, 5));
+        return this.parseJoinName(data.subarray(5));
+    }
+
+    handleConnect(socket, data) {
+        const name = this.parseConnect(socket, data);
+        if (name === null) return;
+        const player = this.joinWorld(socket, name);
+        this.sendConnect(socket, player, this.world, this.world.getSnapshot(this.getInterestArea(socket)));
+    }
+
+    async handleArenaConnect(socket, data) {
+        const name = this.parseConnect(socket, data);
+        if (name === null) return;
+        const player = await this.joinArena(socket, name);
+        const worldState = await this.arenas.getState(socket.arenaId, player.id, socket.viewport);
+        this.sendConnect(socket, player, this.arenas, worldState || { ticks: 0, players: [], lastKillMessage: '' });
+    }
+
+    /**
+     * Resume a dropped session: 0x09 [Version] [CapsLo] [CapsHi] [ViewW] [ViewH]
+     * [TicksLo] [TicksHi] [CountLo] [CountHi] [TokenLen] [Token]
+     * Ticks and Count describe the last packed state the client applied; when they
+     * match what was sent, runs continue from it. Success is answered like a 0x08
+     * connect, with a fresh token. Failure is an empty 0x09 [0] [0].
+     */
+    handleResume(socket, data) {
+        const key = data.subarray(10, 10 + data[9]).toString('hex');
+        const session = this.sessions.get(key);
+        socket.connectVersion = Math.max(1, Math.min(data[0], PROTOCOL_VERSION));
+        this.negotiateCaps(socket, data.readUInt16LE(1));
+        this.handleSetViewport(socket, data.subarray(3, 5));
+
+        if (session) {
+            clearTimeout(session.timer);
+            this.sessions.delete(key);
+        }
+        // Gone if it expired, arenas own the players, or the name has rejoined since
+        if (!session || this.arenas || socket.player ||
+            this.world.getDisconnectedPlayer(session.player.name) !== session.player) {
+            socket.outbox.send(Buffer.from([0x09, 0, 0]));
+            return;
         }
 
+        const { player, codec } = session;
+        this.world.removeDisconnectedPlayer(player.name);
+        if (this.world.getPlayerAtPosition(player.x, player.y) || this.world.getMobAtPosition(player.x, player.y)) {
+            const spawn = GameRules.findSpawn(this.world);
+            player.setPosition(spawn.x, spawn.y);
+        }
+        this.world.addPlayer(player);
         socket.player = player;
+        console.log(`  🔁 TCP Resume: ${player.name}`);
+
+        if (codec.caps === socket.codec.caps && codec.packedBase &&
+            codec.packedBaseTicks === data.readUInt16LE(5) && codec.packedBase.length === data.readUInt16LE(7)) {
+            socket.codec.packedBase = codec.packedBase;
+            socket.codec.packedBaseTicks = codec.packedBaseTicks;
+            socket.codec.entityIds = codec.entityIds; // The run base refers to these ids
+            socket.codec.nextEntityId = codec.nextEntityId;
+        }
+        this.sendConnect(socket, player, this.world, this.world.getSnapshot(this.getInterestArea(socket)));
+    }
+
+    /**
+     * Keep a dropped connection's player and codec for resumeGraceMs
+     */
+    parkSession(socket) {
+        const key = socket.resumeToken.toString('hex');
+        const session = { player: socket.player, codec: socket.codec, timer: null };
+        session.timer = setTimeout(() => this.sessions.delete(key), this.resumeGraceMs);
+        session.timer.unref();
+        this.sessions.set(key, session);
+    }
+
+    /**
+     * Answer a 0x08 connect with everything the client needs for its first frame:
+     * 0x08 [LenLo] [LenHi] [Version] [CapsLo] [CapsHi] [WidthLo] [WidthHi] [HeightLo] [HeightHi]
+     *      [IDLen] [ID] [X] [Y] [Health] [VerLen] [Version] ([TokenLen] [Token] with RESUME)
+     *      ([UdpPortLo] [UdpPortHi] with UDP) [state packet]
+     * The state packet is a complete 0x03 or 0x07 packet in the negotiated codec.
+     */
+    sendConnect(socket, player, world, worldState) {
+        const head = Buffer.alloc(7);
+        head.writeUInt8(socket.connectVersion, 0);
+        head.writeUInt16LE(socket.codec.caps, 1);
+        head.writeUInt16LE(world.width, 3);
+        head.writeUInt16LE(world.height, 5);
+        const parts = [head, this.encodeJoin(socket, player)];
+        if (socket.codec.caps & CAPS.RESUME) {
+            socket.resumeToken = crypto.randomBytes(RESUME_TOKEN_BYTES);
+            parts.push(Buffer.from([RESUME_TOKEN_BYTES]), socket.resumeToken);
+        }
+        if (socket.codec.caps & CAPS.UDP) {
+            parts.push(Buffer.from([this.udpPort & 0xFF, this.udpPort >> 8]));
+        }
+        parts.push(this.encodeState(socket, worldState));
+        const body = Buffer.concat(parts);
+
+        const resp = Buffer.alloc(3 + body.length);
+        resp.writeUInt8(0x08, 0);
+        resp.writeUInt16LE(body.length, 1);
+        body.copy(resp, 3);
+        socket.outbox.send(resp);
+    }
 
+    /**
+     * @param {boolean} withCaps - Answer a 0x06 join, echoing the granted capabilities
+     */
+    sendJoin(socket, player, withCaps = false) {
         // Response: 0x01 [ID_LEN] [ID] [X] [Y] [Health] [VER_LEN] [VERSION]
+        //       or: 0x06 [CAPS_LO] [CAPS_HI] [ID_LEN] ... as above
+        const head = Buffer.alloc(withCaps ? 3 : 1);
+        if (withCaps) {
+            head.writeUInt8(0x06, 0);
+            head.writeUInt16LE(socket.codec.caps, 1);
+        } else {
+            head.writeUInt8(0x01, 0);
+        }
+        socket.outbox.send(this.frame(socket, Buffer.concat([head, this.encodeJoin(socket, player)])));
+    }
+
+    /**
+     * Join reply fields after the type: [ID_LEN] [ID] [X] [Y] [Health] [VER_LEN] [VERSION]
+     * X and Y are 16-bit LE when WIDE_COORDS is negotiated
+     * @returns {Buffer}
+     */
+    encodeJoin(socket, player) {
         const pkg = require('../package.json');
         const verBuf = Buffer.from(pkg.version);
         const idBuf = Buffer.from(player.id);
-        const resp = Buffer.alloc(1 + 1 + idBuf.length + 1 + 1 + 1 + 1 + verBuf.length);
+        const resp = Buffer.alloc(1 + idBuf.length + this.coordSize(socket) * 2 + 1 + 1 + verBuf.length);
         let offset = 0;
-        resp.writeUInt8(0x01, offset++);
         resp.writeUInt8(idBuf.length, offset++);
         idBuf.copy(resp, offset); offset += idBuf.length;
-        resp.writeUInt8(Math.floor(player.x), offset++);
-        resp.writeUInt8(Math.floor(player.y), offset++);
+        offset = this.writeCoord(socket, resp, player.x, offset);
+        offset = this.writeCoord(socket, resp, player.y, offset);
         resp.writeUInt8(player.health, offset++);
         resp.writeUInt8(verBuf.length, offset++);
-        verBuf.copy(resp, offset); offset += verBuf.length;
+        verBuf.copy(resp, offset);
+        return resp;
+    }
 
-        socket.write(resp);
+    /**
+     * @param {number|null} seq - Sequence number of a 0x0B move, null for a plain 0x02 move
+     */
+    handleMove(socket, data, seq = null) {
+        if (data.length < 1) return;
+        if (!socket.player) return this.rejectMove(socket, seq);
+
+        const direction = GameRules.DIRECTIONS[String.fromCharCode(data[0])];
+        const result = GameRules.movePlayer(this.world, socket.player, direction);
+        if (result) {
+            if (!result.collision) {
+                console.log(`  🎮 TCP Move: ${socket.player.name} to (${result.x}, ${result.y})`);
+            }
+            this.sendMove(socket, result, seq);
+        } else {
+            this.rejectMove(socket, seq);
+        }
     }
 
-    handleMove(socket, data) {
-        if (!socket.player) return;
+    async handleArenaMove(socket, data, seq = null) {
         if (data.length < 1) return;
+        if (!socket.player) return this.rejectMove(socket, seq);
+
+        const direction = GameRules.DIRECTIONS[String.fromCharCode(data[0])];
+        const result = await this.arenas.move(socket.arenaId, socket.player.id, direction);
+        if (result) {
+            socket.player.x = result.x;
+            socket.player.y = result.y;
+            socket.player.health = result.health;
+            this.sendMove(socket, result, seq);
+        } else {
+            this.rejectMove(socket, seq);
+        }
+    }
+
+    /**
+     * Batched moves: 0x0C [Seq] [Count] [Dir...] are moves Seq, Seq+1, ... applied
+     * in order. One 0x0B reply answers them all, with the last Seq and where the
+     * player ended up, so a burst of keys costs one round trip.
+     */
+    handleMoveBatch(socket, data) {
+        const dirs = data.subarray(2, 2 + data[1]);
+        if (dirs.length === 0) return;
+        if (!socket.player) return this.rejectMove(socket, (data[0] + dirs.length - 1) & 0xFF);
+
+        const batch = { collision: false, message: '' };
+        for (const dir of dirs) {
+            if (!this.world.getPlayer(socket.player.id)) break; // Lost a fight earlier in the batch
+            const direction = GameRules.DIRECTIONS[String.fromCharCode(dir)];
+            mergeMove(batch, GameRules.movePlayer(this.world, socket.player, direction));
+        }
+        console.log(`  🎮 TCP Moves: ${socket.player.name} x${dirs.length} to (${socket.player.x}, ${socket.player.y})`);
+        this.sendMoveBatch(socket, batch, data[0] + dirs.length - 1);
+    }
 
-        const dirChar = String.fromCharCode(data[0]);
-        let direction = null; // 'up', 'down', 'left', 'right'
+    async handleArenaMoveBatch(socket, data) {
+        const dirs = data.subarray(2, 2 + data[1]);
+        if (dirs.length === 0) return;
+        if (!socket.player) return this.rejectMove(socket, (data[0] + dirs.length - 1) & 0xFF);
+
+        const batch = { collision: false, message: '' };
+        for (const dir of dirs) {
+            const direction = GameRules.DIRECTIONS[String.fromCharCode(dir)];
+            const result = await this.arenas.move(socket.arenaId, socket.player.id, direction);
+            if (result) {
+                socket.player.x = result.x;
+                socket.player.y = result.y;
+                socket.player.health = result.health;
+            }
+            mergeMove(batch, result);
+        }
+        this.sendMoveBatch(socket, batch, data[0] + dirs.length - 1);
+    }
 
-        // Simple char mapping
-        if (dirChar === 'u') direction = 'up';
-        if (dirChar === 'd') direction = 'down';
-        if (dirChar === 'l') direction = 'left';
-        if (dirChar === 'r') direction = 'right';
+    sendMoveBatch(socket, batch, lastSeq) {
+        const { player } = socket;
+        this.sendMove(socket, {
+            x: player.x, y: player.y, health: player.health, collision: batch.collision, message: batch.message
+        }, lastSeq & 0xFF);
+    }
 
-        if (direction) {
-            this.world.updatePlayerActivity(socket.player.id);
+    /**
+     * Answer a move that was not applied. Plain moves get no reply; a sequenced
+     * move is still acknowledged with the unchanged position, so the client can
+     * roll its prediction back. A socket without a player acks with an empty
+     * (0, 0, health 0) one, which still clears the client's pending moves.
+     */
+    rejectMove(socket, seq) {
+        if (seq === null) return;
+        const player = socket.player || { x: 0, y: 0, health: 0 };
+        this.sendMove(socket, {
+            x: player.x, y: player.y, health: player.health, collision: false, message: ''
+        }, seq);
+    }
 
-            let newX = socket.player.x;
-            let newY = socket.player.y;
+    sendMove(socket, result, seq = null) {
+        // Send State Update back to client: 0x02 [X] [Y] [Health] [Collision] [MsgLen] [Msg...],
+        // or 0x0B [Seq] and the same fields for a sequenced move
+        const msgBuf = Buffer.from(result.message);
+        const head = seq === null ? 1 : 2;
+        const resp = Buffer.alloc(head + 3 + this.coordSize(socket) * 2 + msgBuf.length);
+        let offset = resp.writeUInt8(seq === null ? 0x02 : 0x0B, 0); // Type
+        if (seq !== null) {
+            offset = resp.writeUInt8(seq, offset);
+        }
+        offset = this.writeCoord(socket, resp, result.x, offset);
+        offset = this.writeCoord(socket, resp, result.y, offset);
+        offset = resp.writeUInt8(result.health, offset);
+        offset = resp.writeUInt8(result.collision ? 1 : 0, offset); // Collision flag
+        offset = resp.writeUInt8(msgBuf.length, offset);            // Message length
+        msgBuf.copy(resp, offset);
+        socket.outbox.send(this.frame(socket, resp));
+    }
 
-            switch (direction) {
-                case 'up': newY = Math.max(0, newY - 1); break;
-                case 'down': newY = Math.min(this.world.height - 1, newY + 1); break;
-                case 'left': newX = Math.max(0, newX - 1); break;
-                case 'right': newX = Math.min(this.world.width - 1, newX + 1); break;
-            }
+    handleSetViewport(socket, data) {
+        // Viewport: 0x04 [Width] [Height] - no response
+        const width = data[0];
+        const height = data[1];
+        socket.viewport = (width > 0 && height > 0) ? { width, height } : null;
+    }
 
-            if (!this.world.isValidPosition(newX, newY)) {
-                // Out of bounds, ignore
-                // Send current pos back to sync
-            } else {
-                // Check collisions
-                const collidingPlayer = this.world.getPlayerAtPosition(newX, newY, socket.player.id);
-                const collidingMob = this.world.getMobAtPosition(newX, newY);
-                let hadCollision = false;
-                let battleMsg = '';
-
-                if (collidingPlayer) {
-                    hadCollision = true;
-                    const result = CombatResolver.resolveBattle(socket.player, collidingPlayer);
-                    console.log(`  ⚔️  TCP Combat: "${socket.player.name}" vs "${collidingPlayer.name}" - Winner: "${result.finalWinnerName}"`);
-                    battleMsg = `${result.finalWinnerName} defeats ${result.finalLoserName}!`;
-                    if (result.finalLoserId === socket.player.id) {
-                        this.world.removePlayer(socket.player.id);
-                        this.world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'player');
-                    } else {
-                        this.world.removePlayer(collidingPlayer.id);
-                        this.world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'player');
-                    }
-                    this.world.setLastCombat(result);
-                    // We don't move if we fought
-                } else if (collidingMob) {
-                    hadCollision = true;
-                    const result = CombatResolver.resolveBattle(socket.player, collidingMob);
-                    console.log(`  ⚔️  TCP Combat: "${socket.player.name}" vs "${collidingMob.name}" - Winner: "${result.finalWinnerName}"`);
-                    battleMsg = `${result.finalWinnerName} defeats ${result.finalLoserName}!`;
-                    if (result.finalLoserId === socket.player.id) {
-                        this.world.removePlayer(socket.player.id);
-                        this.world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'player');
-                    } else {
-                        this.world.removeMob(collidingMob.id);
-                        this.world.setKillMessage(result.finalWinnerName, result.finalLoserName, 'mob');
-                    }
-                    this.world.setLastCombat(result);
-                } else {
-                    // Move
-                    socket.player.setPosition(newX, newY);
-                    console.log(`  🎮 TCP Move: ${socket.player.name} to (${newX}, ${newY})`);
-                }
-
-                // Truncate message to 39 chars max
-                if (battleMsg.length > 39) {
-                    battleMsg = battleMsg.substring(0, 39);
-                }
-
-                // Send State Update back to client: 0x02 [X] [Y] [Health] [Collision] [MsgLen] [Msg...]
-                const msgBuf = Buffer.from(battleMsg);
-                const resp = Buffer.alloc(6 + msgBuf.length);
-                resp.writeUInt8(0x02, 0); // Type
-                resp.writeUInt8(Math.floor(socket.player.x), 1);
-                resp.writeUInt8(Math.floor(socket.player.y), 2);
-                resp.writeUInt8(socket.player.health, 3);
-                resp.writeUInt8(hadCollision ? 1 : 0, 4); // Collision flag
-                resp.writeUInt8(msgBuf.length, 5);        // Message length
-                msgBuf.copy(resp, 6);
-                socket.write(resp);
-            }
+    /**
+     * Area of interest for a client: its viewport around its player, or the whole world
+     * @returns {Object|null} - Inclusive rect, null for everything
+     */
+    getInterestArea(socket) {
+        if (!socket.viewport || !socket.player) {
+            return null;
         }
+        return this.world.getViewportRect(
+            Math.floor(socket.player.x), Math.floor(socket.player.y),
+            socket.viewport.width, socket.viewport.height
+        );
     }
 
     handleGetState(socket) {
         // Trigger world update (tick, mob movement, etc)
-        const worldState = this.world.getState();
+        this.sendState(socket, this.world.getState(this.getInterestArea(socket)));
+    }
+
+    async handleArenaGetState(socket) {
+        // Arenas tick on their worker; this only fetches the latest snapshot
+        const worldState = socket.arenaId === null ? null
+            : await this.arenas.getState(socket.arenaId, socket.player.id, socket.viewport);
+        this.sendState(socket, worldState || { ticks: 0, players: [], lastKillMessage: '' });
+    }
+
+    sendState(socket, worldState) {
+        // Snapshots are latest-only: a stale one still waiting is replaced, not queued
+        socket.outbox.sendSnapshot(this.frame(socket, this.encodeState(socket, worldState)));
+    }
+
+    /**
+     * Insert the body length after the type byte when FRAMED is negotiated,
+     * so the client can fetch a whole reply in two reads
+     * @param {Buffer} packet - [Type] [Body...]
+     * @returns {Buffer} - [Type] [LenLo] [LenHi] [Body...], or packet unchanged
+     */
+    frame(socket, packet) {
+        if (!(socket.codec.caps & CAPS.FRAMED) || LENGTH_PREFIXED.has(packet[0])) {
+            return packet;
+        }
+        const framed = Buffer.alloc(packet.length + 2);
+        framed.writeUInt8(packet[0], 0);
+        framed.writeUInt16LE(packet.length - 1, 1);
+        packet.copy(framed, 3, 1);
+        return framed;
+    }
+
+    /**
+     * Encode a state packet in this client's codec: 0x07 when PACKED is negotiated, otherwise 0x03
+     * @param {Object} options - `delta`: false for unreliable transports, so records
+     *   are never encoded as repeats of an earlier packet
+     * @returns {Buffer}
+     */
+    encodeState(socket, worldState, options = {}) {
+        socket.lastTicks = worldState.ticks % 65536;
+        if (socket.codec.caps & CAPS.PACKED) {
+            return this.encodePackedState(socket, worldState,
+                options.delta !== false && (socket.codec.caps & CAPS.DELTA) !== 0);
+        }
         const ticks = worldState.ticks % 65536; // Limit to 16-bit
 
-        const players = Array.from(this.world.players.values());
-        const mobs = Array.from(this.world.mobs.values());
-        const all = [...players, ...mobs];
+        const all = worldState.players;
 
         const count = Math.min(all.length, 255);
+        const ids = socket.codec.caps & CAPS.NUMERIC_IDS ? this.entityNumbers(socket, all.slice(0, count)) : null;
 
         // Get any pending combat message (e.g., from hunter attacks)
         let combatMsg = worldState.lastKillMessage || '';
@@ -228,7 +768,8 @@ class TcpServer {
         const msgBuf = Buffer.from(combatMsg);
 
         // Format: 0x03 [Count] [TicksLow] [TicksHigh] [MsgLen] [Msg...] [Entity1: Type X Y] [Entity2: ...]
-        const buf = Buffer.alloc(5 + msgBuf.length + count * 3);
+        // With NUMERIC_IDS each entity is [Type] [IdLo] [IdHi] [X] [Y]
+        const buf = Buffer.alloc(5 + msgBuf.length + count * ((ids ? 3 : 1) + this.coordSize(socket) * 2));
         let offset = 0;
         buf.writeUInt8(0x03, offset++);
         buf.writeUInt8(count, offset++);
@@ -239,30 +780,187 @@ class TcpServer {
 
         for (let i = 0; i < count; i++) {
             const ent = all[i];
-            let typeChar = 'O';
-            if (ent.type === 'player') {
-                typeChar = (socket.player && ent.id === socket.player.id) ? 'M' : 'P';
-            } else if (ent.isHunter) {
-                typeChar = 'H';
-            } else {
-                typeChar = 'E';
+            buf.writeUInt8(this.entityType(socket, ent).charCodeAt(0), offset++);
+            if (ids) {
+                offset = buf.writeUInt16LE(ids[i], offset);
+            }
+            offset = this.writeCoord(socket, buf, ent.x, offset);
+            offset = this.writeCoord(socket, buf, ent.y, offset);
+        }
+        return buf;
+    }
+
+    /**
+     * Type character for an entity as seen by this client
+     * @returns {string} - M (me), P (player), H (hunter) or E (enemy)
+     */
+    entityType(socket, ent) {
+        if (ent.type === 'player') {
+            return (socket.player && ent.id === socket.player.id) ? 'M' : 'P';
+        }
+        return ent.isHunter ? 'H' : 'E';
+    }
+
+    /**
+     * Numeric ids for this client's NUMERIC_IDS snapshots. An entity keeps its
+     * number while it stays in the client's snapshots; the numbers of entities
+     * that drop out are forgotten, and only handed out again after the 16-bit
+     * counter wraps.
+     * @param {Array} entities - Entities of the snapshot being encoded
+     * @returns {number[]} - Id of each entity, 1..65535
+     */
+    entityNumbers(socket, entities) {
+        const codec = socket.codec;
+        const current = new Map();
+        let inUse = null;
+        const ids = entities.map(ent => {
+            let n = codec.entityIds.get(ent.id);
+            if (n === undefined) {
+                inUse = inUse || new Set(codec.entityIds.values());
+                do {
+                    n = codec.nextEntityId = (codec.nextEntityId % 0xFFFF) + 1;
+                } while (inUse.has(n));
+                inUse.add(n);
             }
+            current.set(ent.id, n);
+            return n;
+        });
+        codec.entityIds = current;
+        return ids;
+    }
+
+    /**
+     * Encode a packed 0x07 state packet (PACKED capability)
+     *
+     * Format: 0x07 [LenLo] [LenHi] [Count varint] [TicksLow] [TicksHigh] [MsgLen] [Msg...]
+     *         [XBits] [YBits] ([IdBits] with NUMERIC_IDS) [Records...]
+     * Records are an MSB-first bitstream, one per entity:
+     *   0 [Type:2] [Id:IdBits] [X:XBits] [Y:YBits]  - literal, Type indexes PACKED_TYPES
+     *   1 [Run-1:4]                                 - the next Run records match the previous packet
+     * Runs refer to the last packed state sent over this TCP connection, so
+     * they are only used when that packet is sure to reach the client first.
+     *
+     * @param {boolean} delta - Allow runs against the previous packet
+     * @returns {Buffer}
+     */
+    encodePackedState(socket, worldState, delta) {
+        const ticks = worldState.ticks % 65536;
+        let combatMsg = worldState.lastKillMessage || '';
+        if (combatMsg.length > 39) {
+            combatMsg = combatMsg.substring(0, 39);
+        }
+        const msgBuf = Buffer.from(combatMsg);
+
+        const ids = socket.codec.caps & CAPS.NUMERIC_IDS ? this.entityNumbers(socket, worldState.players) : null;
+        const records = worldState.players.map((ent, i) => ({
+            type: PACKED_TYPES.indexOf(this.entityType(socket, ent)),
+            id: ids ? ids[i] : 0,
+            x: Math.floor(ent.x),
+            y: Math.floor(ent.y)
+        }));
+        const xBits = bitsFor(Math.max(0, ...records.map(r => r.x)));
+        const yBits = bitsFor(Math.max(0, ...records.map(r => r.y)));
+        const idBits = ids ? bitsFor(Math.max(0, ...ids)) : 0;
+
+        // A snapshot still waiting in the outbox may be replaced before it is
+        // sent, so never encode against it
+        const base = delta && !socket.outbox.pendingSnapshot ? socket.codec.packedBase : null;
+        if (delta) {
+            socket.codec.packedBase = records;
+            socket.codec.packedBaseTicks = ticks;
+        }
 
-            buf.writeUInt8(typeChar.charCodeAt(0), offset++);
-            buf.writeUInt8(Math.floor(ent.x), offset++);
-            buf.writeUInt8(Math.floor(ent.y), offset++);
+        const bits = new BitWriter();
+        for (let i = 0; i < records.length;) {
+            let run = 0;
+            while (base && run < (1 << PACKED_RUN_BITS) && i + run < records.length && i + run < base.length &&
+                   sameRecord(records[i + run], base[i + run])) {
+                run++;
+            }
+            if (run > 0) {
+                bits.write(1, 1);
+                bits.write(run - 1, PACKED_RUN_BITS);
+                i += run;
+            } else {
+                const r = records[i++];
+                bits.write(0, 1);
+                bits.write(r.type, 2);
+                bits.write(r.id, idBits);
+                bits.write(r.x, xBits);
+                bits.write(r.y, yBits);
+            }
         }
 
-        socket.write(buf);
+        const header = Buffer.alloc(3);
+        header.writeUInt16LE(ticks, 0);
+        header.writeUInt8(msgBuf.length, 2);
+        const body = Buffer.concat([
+            encodeVarint(records.length),
+            header,
+            msgBuf,
+            Buffer.from(ids ? [xBits, yBits, idBits] : [xBits, yBits]),
+            bits.toBuffer()
+        ]);
+
+        const buf = Buffer.alloc(3 + body.length);
+        buf.writeUInt8(0x07, 0);
+        buf.writeUInt16LE(body.length, 1);
+        body.copy(buf, 3);
+        return buf;
+    }
+
+    /**
+     * Find the connection playing as a player
+     * @returns {net.Socket|null}
+     */
+    findClientByPlayerId(playerId) {
+        for (const socket of this.clients) {
+            if (socket.player && socket.player.id === playerId) {
+                return socket;
+            }
+        }
+        return null;
     }
 
     handleClose(socket) {
         this.clients.delete(socket);
-        if (socket.player) {
+        socket.outbox.close();
+        if (this.arenas) {
+            // Wait for in-flight requests: a join still queued sets socket.player when it resolves
+            socket.queue = socket.queue
+                .then(() => {
+                    if (!socket.player) return null;
+                    console.log(`TCP Client Disconnected: ${socket.player.name}`);
+                    return this.arenas.leave(socket.arenaId, socket.player.id);
+                })
+                .catch((e) => console.error(`Error leaving arena: ${e.message}`));
+        } else if (socket.player) {
             console.log(`TCP Client Disconnected: ${socket.player.name}`);
             this.world.removePlayer(socket.player.id);
+            if (socket.resumeToken) {
+                this.parkSession(socket);
+            }
         }
     }
 }
 
+function sameRecord(a, b) {
+    return a.type === b.type && a.id === b.id && a.x === b.x && a.y === b.y;
+}
+
+/**
+ * Per-connection encoding state
+ * @param {number} caps - Negotiated capabilities
+ * @returns {Object} - packedBase holds the last packed TCP records; entityIds
+ *   maps entity id -> NUMERIC_IDS number for the entities last sent
+ */
+function newCodec(caps) {
+    return { caps, packedBase: null, packedBaseTicks: 0, entityIds: new Map(), nextEntityId: 0 };
+}
+
+TcpServer.PROTOCOL_VERSION = PROTOCOL_VERSION;
+TcpServer.PACKED_TYPES = PACKED_TYPES;
+TcpServer.CAPS = CAPS;
+TcpServer.SERVER_CAPS = SERVER_CAPS;
+
 module.exports = TcpServer;
@@ -0,0 +1,128 @@
+/**
+ * UDP Snapshot Server
+ *
+ * Optional unreliable channel for state snapshots. Joins and moves stay
+ * on TCP; a client that subscribes here gets its area-of-interest
+ * snapshot pushed every tick as a sequence-numbered datagram, so a lost
+ * or late snapshot is simply superseded by the next one instead of
+ * holding up the stream.
+ *
+ * Subscribe:  0x10 [IdLen] [PlayerId]   (resend every few seconds as a keepalive)
+ * Snapshot:   0x11 [SeqLo] [SeqHi] [state packet as sent over TCP]
+ *
+ * Packed 0x07 snapshots sent here never use runs, since the packet they
+ * would refer to may have been lost.
+ */
+
+const dgram = require('dgram');
+
+const DEFAULT_OPTIONS = {
+  tickMs: 100,                 // Snapshot interval
+  subscriptionTimeoutMs: 10000 // Drop subscribers that stop sending keepalives
+};
+
+class UdpServer {
+  /**
+   * @param {World} world - World to snapshot (ticked here while anyone is subscribed)
+   * @param {number} port - UDP port to listen on
+   * @param {TcpServer} tcpServer - Server holding the subscribers' TCP sessions
+   * @param {Object} options - Overrides for DEFAULT_OPTIONS
+   */
+  constructor(world, port, tcpServer, options = {}) {
+    this.world = world;
+    this.port = port;
+    this.tcp = tcpServer;
+    this.options = { ...DEFAULT_OPTIONS, ...options };
+    this.socket = dgram.createSocket('udp4');
+    this.subscriptions = new Map(); // "address:port" -> {address, port, client, playerId, lastSeen}
+    this.seq = 0;
+    this.timer = null;
+  }
+
+  start() {
+    this.socket.on('message', (msg, rinfo) => this.handleMessage(msg, rinfo));
+    this.socket.on('error', (err) => console.error(`UDP error: ${err.message}`));
+    this.socket.bind(this.port, () => {
+      // Offered to clients in their 0x08 replies from now on
+      this.tcp.udpPort = this.socket.address().port;
+      console.log(`KillZone UDP snapshots on port ${this.tcp.udpPort}`);
+    });
+    this.timer = setInterval(() => this.broadcast(), this.options.tickMs);
+  }
+
+  stop(callback) {
+    this.tcp.udpPort = 0;
+    clearInterval(this.timer);
+    this.timer = null;
+    this.subscriptions.clear();
+    this.socket.close(callback);
+  }
+
+  handleMessage(msg, rinfo) {
+    if (msg.length < 2 || msg[0] !== 0x10 || msg.length < 2 + msg[1]) {
+      return;
+    }
+    const playerId = msg.subarray(2, 2 + msg[1]).toString();
+    const client = this.tcp.findClientByPlayerId(playerId);
+
+    // Only the host holding the TCP session may subscribe, so the server
+    // can't be used to aim snapshots at someone else
+    if (!client || normalizeAddress(client.remoteAddress) !== normalizeAddress(rinfo.address)) {
+      return;
+    }
+
+    const key = `${rinfo.address}:${rinfo.port}`;
+    if (!this.subscriptions.has(key)) {
+      console.log(`  📡 UDP subscribe: ${client.player.name} at ${key}`);
+    }
+    this.subscriptions.set(key, {
+      address: rinfo.address,
+      port: rinfo.port,
+      client,
+      playerId,
+      lastSeen: Date.now()
+    });
+  }
+
+  /**
+   * Tick the world and push each subscriber its snapshot
+   */
+  broadcast() {
+    if (this.subscriptions.size === 0) {
+      return;
+    }
+    const now = Date.now();
+    if (this.world.tick) {
+      this.world.tick(); // A ZoneManager's zones tick on their own loops
+    }
+    this.seq = (this.seq + 1) & 0xFFFF;
+
+    for (const [key, sub] of this.subscriptions) {
+      const { client } = sub;
+      if (client.destroyed || !client.player || client.player.id !== sub.playerId ||
+          now - sub.lastSeen > this.options.subscriptionTimeoutMs) {
+        this.subscriptions.delete(key);
+        continue;
+      }
+
+      const state = this.world.getSnapshot(this.tcp.getInterestArea(client));
+      const body = this.tcp.encodeState(client, state, { delta: false });
+      const datagram = Buffer.alloc(3 + body.length);
+      datagram.writeUInt8(0x11, 0);
+      datagram.writeUInt16LE(this.seq, 1);
+      body.copy(datagram, 3);
+      this.socket.send(datagram, sub.port, sub.address);
+    }
+  }
+}
+
+/**
+ * Strip the IPv4-mapped IPv6 prefix so TCP and UDP addresses compare equal
+ */
+function normalizeAddress(address) {
+  return (address || '').replace(/^::ffff:/, '');
+}
+
+UdpServer.DEFAULT_OPTIONS = DEFAULT_OPTIONS;
+
+module.exports = UdpServer;
@@ -2,16 +2,29 @@
  * World State Management
  * 
  * Manages the shared game world state including:
- * - World dimensions (40x20 grid)
+ * - World dimensions (40x20 by default, up to 65535x65535)
  * - Player entity tracking
  * - Position validation
+ * - Chunked spatial index for position and area-of-interest queries
  * - World persistence across client connections
  */
 
+const SpatialGrid = require('./spatial_grid');
+
+const VIEW_MARGIN = 4;  // Extra cells sent around a client viewport
+const CHUNK_SIZE = 32;  // Spatial index chunk size (chunks are allocated lazily)
+const MAX_DIMENSION = 65535; // Coordinates travel as 16-bit values on the wire
+
 class World {
-  constructor(width = 40, height = 20) {
-    this.width = width;
-    this.height = height;
+  /**
+   * @param {number} width - World width
+   * @param {number} height - World height
+   * @param {Object} bounds - Optional inclusive rect this world owns (zones); defaults to everything
+   */
+  constructor(width = 40, height = 20, bounds = null) {
+    this.width = Math.max(1, Math.min(MAX_DIMENSION, width));
+    this.height = Math.max(1, Math.min(MAX_DIMENSION, height));
+    this.bounds = bounds || { x0: 0, y0: 0, x1: this.width - 1, y1: this.height - 1 };
     this.players = new Map(); // playerId -> Player object
     this.mobs = new Map(); // mobId -> Mob object
     this.disconnectedPlayers = new Map(); // playerName -> Player object (for reconnection)
@@ -26,6 +39,11 @@ class World {
     this.lastKillMessage = '';
     this.lastKillTimestamp = 0;
     this.previousPlayerNames = new Set(); // Track player names for rejoin detection
+    this.grid = new SpatialGrid(CHUNK_SIZE); // Players and mobs by position
+    // Zone hooks, left null for a standalone world (see ZoneManager)
+    this.removedMobIds = null; // Ids of mobs removed here, for the owner to collect
+    this.targetWorlds = null;  // rect -> worlds whose players hunters here may chase
+    this.collectRemovals = null; // Lets the owner collect a kill made here by another world's hunter
   }
 
   /**
@@ -39,6 +57,7 @@ class World {
     }
     player.lastActivity = Date.now();  // Track activity for disconnect cleanup
     this.players.set(player.id, player);
+    this.grid.insert(player);
     // Track player name for rejoin detection
     if (player.name) {
       this.previousPlayerNames.add(player.name);
@@ -84,6 +103,7 @@ class World {
       // Store in disconnected players by name for reconnection
       this.disconnectedPlayers.set(player.name, player);
       this.players.delete(playerId);
+      this.grid.remove(player);
       this.timestamp = Date.now();
       return true;
     }
@@ -151,12 +171,12 @@ class World {
    * @returns {Player|null} - Player at position or null if empty
    */
   getPlayerAtPosition(x, y, excludePlayerId = null) {
-    for (const player of this.players.values()) {
-      if (player.x === x && player.y === y) {
-        if (excludePlayerId && player.id === excludePlayerId) {
+    for (const entity of this.grid.getAt(x, y)) {
+      if (entity.type === 'player') {
+        if (excludePlayerId && entity.id === excludePlayerId) {
           continue;
         }
-        return player;
+        return entity;
       }
     }
     return null;
@@ -167,9 +187,9 @@ class World {
   }
 
   getMobAtPosition(x, y) {
-    for (const mob of this.mobs.values()) {
-      if (mob.x === x && mob.y === y) {
-        return mob;
+    for (const entity of this.grid.getAt(x, y)) {
+      if (entity.type === 'mob') {
+        return entity;
       }
     }
     return null;
@@ -185,6 +205,7 @@ class World {
       return false;
     }
     this.mobs.set(mob.id, mob);
+    this.grid.insert(mob);
     this.timestamp = Date.now();
     return true;
   }
@@ -195,11 +216,102 @@ class World {
    * @returns {boolean} - Success status
    */
   removeMob(mobId) {
-    const removed = this.mobs.delete(mobId);
-    if (removed) {
-      this.timestamp = Date.now();
+    const mob = this.mobs.get(mobId);
+    if (!mob) {
+      return false;
+    }
+    this.mobs.delete(mobId);
+    this.grid.remove(mob);
+    if (this.removedMobIds) {
+      this.removedMobIds.push(mobId);
+    }
+    this.timestamp = Date.now();
+    return true;
+  }
+
+  /**
+   * Check if a position is inside the area this world owns
+   * @returns {boolean}
+   */
+  ownsPosition(x, y) {
+    const b = this.bounds;
+    return x >= b.x0 && x <= b.x1 && y >= b.y0 && y <= b.y1;
+  }
+
+  /**
+   * Take a live entity out of this world without disconnect bookkeeping (zone handoff)
+   * @param {Object} entity - Player or Mob
+   * @returns {boolean} - True if the entity was here
+   */
+  detachEntity(entity) {
+    const store = entity.type === 'player' ? this.players : this.mobs;
+    if (store.get(entity.id) !== entity) {
+      return false;
+    }
+    store.delete(entity.id);
+    this.grid.remove(entity);
+    this.timestamp = Date.now();
+    return true;
+  }
+
+  /**
+   * Adopt a live entity handed off from another world (zone handoff)
+   * @param {Object} entity - Player or Mob
+   */
+  attachEntity(entity) {
+    const store = entity.type === 'player' ? this.players : this.mobs;
+    store.set(entity.id, entity);
+    this.grid.insert(entity);
+    this.timestamp = Date.now();
+  }
+
+  /**
+   * Move a player or mob and keep the spatial index in sync
+   * @param {Object} entity - Player or Mob
+   * @param {number} x - New X coordinate
+   * @param {number} y - New Y coordinate
+   */
+  moveEntity(entity, x, y) {
+    entity.setPosition(x, y);
+    this.grid.update(entity);
+  }
+
+  /**
+   * Get the area a client viewport covers, plus a margin
+   * The viewport is centred on (centerX, centerY) and clamped to the world edges.
+   * @param {number} centerX - Viewer X
+   * @param {number} centerY - Viewer Y
+   * @param {number} viewWidth - Viewport width in cells
+   * @param {number} viewHeight - Viewport height in cells
+   * @param {number} margin - Extra cells around the viewport
+   * @returns {Object} - Inclusive rect {x0, y0, x1, y1}
+   */
+  getViewportRect(centerX, centerY, viewWidth, viewHeight, margin = VIEW_MARGIN) {
+    const originX = Math.max(0, Math.min(centerX - Math.floor(viewWidth / 2), this.width - viewWidth));
+    const originY = Math.max(0, Math.min(centerY - Math.floor(viewHeight / 2), this.height - viewHeight));
+    return {
+      x0: Math.max(0, originX - margin),
+      y0: Math.max(0, originY - margin),
+      x1: Math.min(this.width - 1, originX + viewWidth - 1 + margin),
+      y1: Math.min(this.height - 1, originY + viewHeight - 1 + margin)
+    };
+  }
+
+  /**
+   * Get players and mobs inside a rect, players first
+   * @param {Object} rect - Inclusive rect {x0, y0, x1, y1}
+   * @returns {Array} - Matching entities
+   */
+  getEntitiesInRect(rect) {
+    // A rect covering the whole world keeps the stable Map order clients rely on
+    if (rect.x0 <= 0 && rect.y0 <= 0 && rect.x1 >= this.width - 1 && rect.y1 >= this.height - 1) {
+      return [...this.players.values(), ...this.mobs.values()];
     }
-    return removed;
+    const found = this.grid.queryRect(rect.x0, rect.y0, rect.x1, rect.y1);
+    return [
+      ...found.filter(e => e.type === 'player'),
+      ...found.filter(e => e.type !== 'player')
+    ];
   }
 
   setLastCombat(result) {
@@ -255,15 +367,23 @@ class World {
     
     for (const mob of this.mobs.values()) {
       if (mob.isHunter) {
-        // Hunter mob: look for nearby players
+        // Hunter mob: look for nearby players (in neighbouring zones too)
         let nearestPlayer = null;
         let nearestDistance = Infinity;
+        let targetWorld = this;
         
-        for (const player of this.players.values()) {
-          const distance = Math.abs(mob.x - player.x) + Math.abs(mob.y - player.y);
-          if (distance <= 10 && distance < nearestDistance) {
-            nearestPlayer = player;
-            nearestDistance = distance;
+        const rect = { x0: mob.x - 10, y0: mob.y - 10, x1: mob.x + 10, y1: mob.y + 10 };
+        for (const world of this.targetWorlds ? this.targetWorlds(rect) : [this]) {
+          for (const player of world.grid.queryRect(rect.x0, rect.y0, rect.x1, rect.y1)) {
+            if (player.type !== 'player') {
+              continue;
+            }
+            const distance = Math.abs(mob.x - player.x) + Math.abs(mob.y - player.y);
+            if (distance <= 10 && distance < nearestDistance) {
+              nearestPlayer = player;
+              nearestDistance = distance;
+              targetWorld = world;
+            }
           }
         }
         
@@ -285,7 +405,10 @@ class World {
             
             // Remove loser
             if (combatResult.finalLoserId === nearestPlayer.id) {
-              this.removePlayer(nearestPlayer.id);
+              targetWorld.removePlayer(nearestPlayer.id);
+              if (targetWorld !== this && targetWorld.collectRemovals) {
+                targetWorld.collectRemovals();
+              }
               this.setKillMessage(combatResult.finalWinnerName, combatResult.finalLoserName, 'player');
               console.log(`  ⚔️  Hunter Combat: "${mob.name}" vs "${nearestPlayer.name}" - Winner: "${combatResult.finalWinnerName}" (${combatResult.finalScore})`);
             } else {
@@ -311,6 +434,7 @@ class World {
         // Regular mob: move randomly
         mob.moveRandom(this.width, this.height);
       }
+      this.grid.update(mob);
     }
   }
 
@@ -331,8 +455,8 @@ class World {
         let x, y;
         let attempts = 0;
         do {
-          x = Math.floor(Math.random() * this.width);
-          y = Math.floor(Math.random() * this.height);
+          x = this.bounds.x0 + Math.floor(Math.random() * (this.bounds.x1 - this.bounds.x0 + 1));
+          y = this.bounds.y0 + Math.floor(Math.random() * (this.bounds.y1 - this.bounds.y0 + 1));
           attempts++;
         } while (this.getPlayerAtPosition(x, y) !== null && attempts < 10);
         
@@ -361,10 +485,30 @@ class World {
 
   /**
    * Get world state snapshot for API responses
+   * @param {Object} area - Optional rect {x0, y0, x1, y1} limiting the entities returned
+   * @returns {Object} - World state object
+   */
+  getState(area = null) {
+    this.tick();  /* Increment world ticks on each state query */
+    return this.getSnapshot(area);
+  }
+
+  /**
+   * Get a state snapshot without advancing the world (for worlds ticked on a timer)
+   * @param {Object} area - Optional rect {x0, y0, x1, y1} limiting the entities returned
    * @returns {Object} - World state object
    */
-  getState() {
-    this.ticks++;  /* Increment world ticks on each state query */
+  getSnapshot(area = null) {
+    /* Combine players and mobs for the response */
+    const entities = area ? this.getEntitiesInRect(area) : [...this.players.values(), ...this.mobs.values()];
+    return this.buildState(entities);
+  }
+
+  /**
+   * Advance the simulation one step: move mobs and expire old messages
+   */
+  tick() {
+    this.ticks++;
     
     /* Update mobs every tick */
     this.updateMobs();
@@ -376,27 +520,30 @@ class World {
         this.clearKillMessage();
       }
     }
-    
-    /* Combine players and mobs for the response */
-    const allEntities = [
-      ...this.getAllPlayers().map(p => ({
-        id: p.id,
-        x: p.x,
-        y: p.y,
-        health: p.health,
-        status: p.status,
-        type: 'player'
-      })),
-      ...this.getAllMobs().map(m => ({
-        id: m.id,
-        x: m.x,
-        y: m.y,
-        health: m.health,
-        status: m.status,
-        type: 'mob',
-        isHunter: m.isHunter || false
-      }))
-    ];
+  }
+
+  /**
+   * Build a state snapshot from a list of entities without advancing the world
+   * @param {Array} entities - Players and mobs to include
+   * @returns {Object} - World state object
+   */
+  buildState(entities) {
+    const allEntities = entities.map(e => (e.type === 'player' ? {
+      id: e.id,
+      x: e.x,
+      y: e.y,
+      health: e.health,
+      status: e.status,
+      type: 'player'
+    } : {
+      id: e.id,
+      x: e.x,
+      y: e.y,
+      health: e.health,
+      status: e.status,
+      type: 'mob',
+      isHunter: e.isHunter || false
+    }));
     
     return {
       width: this.width,
@@ -421,6 +568,7 @@ class World {
   reset() {
     this.players.clear();
     this.mobs.clear();
+    this.grid.clear();
     this.timestamp = Date.now();
     this.lastCombatLog = '';
     this.lastCombatTimestamp = 0;
@@ -433,4 +581,8 @@ class World {
   }
 }
 
+World.VIEW_MARGIN = VIEW_MARGIN;
+World.CHUNK_SIZE = CHUNK_SIZE;
+World.MAX_DIMENSION = MAX_DIMENSION;
+
 module.exports = World;
@@ -0,0 +1,426 @@
+/**
+ * Zone Manager
+ *
+ * Splits one logical world into a grid of zones. Each zone is a World
+ * with its own entity store, spatial index and tick loop, and owns one
+ * rectangle of the map. Entities keep global coordinates, so handing one
+ * to a neighbouring zone is a detach/attach of the same object.
+ *
+ * Exposes the World interface used by TcpServer and the REST routes, so
+ * either can be handed a ZoneManager instead of a World.
+ */
+
+const World = require('./world');
+
+const MESSAGE_TTL_MS = 4000; // Kill messages expire like World's
+
+class ZoneManager {
+  /**
+   * @param {number} width - World width
+   * @param {number} height - World height
+   * @param {number} zonesX - Zone columns
+   * @param {number} zonesY - Zone rows
+   */
+  constructor(width = 40, height = 20, zonesX = 2, zonesY = 1) {
+    this.width = Math.max(1, Math.min(World.MAX_DIMENSION, width));
+    this.height = Math.max(1, Math.min(World.MAX_DIMENSION, height));
+    this.zonesX = Math.max(1, Math.min(zonesX, this.width));
+    this.zonesY = Math.max(1, Math.min(zonesY, this.height));
+    this.zoneWidth = Math.ceil(this.width / this.zonesX);
+    this.zoneHeight = Math.ceil(this.height / this.zonesY);
+
+    this.zones = [];
+    for (let zy = 0; zy < this.zonesY; zy++) {
+      for (let zx = 0; zx < this.zonesX; zx++) {
+        const bounds = {
+          x0: zx * this.zoneWidth,
+          y0: zy * this.zoneHeight,
+          x1: Math.min(this.width, (zx + 1) * this.zoneWidth) - 1,
+          y1: Math.min(this.height, (zy + 1) * this.zoneHeight) - 1
+        };
+        const zone = new World(this.width, this.height, bounds);
+        zone.id = this.zones.length;
+        zone.removedMobIds = [];
+        zone.targetWorlds = (rect) => this.zonesInRect(rect);
+        zone.collectRemovals = () => this.collectZoneRemovals(zone);
+        this.zones.push(zone);
+      }
+    }
+
+    this.entityZones = new Map(); // entityId -> zone currently simulating it
+    this.disconnectedPlayers = new Map();
+    this.previousPlayerNames = new Set();
+    this.handoffs = 0;
+    this.timers = [];
+    this.reset();
+  }
+
+  // --- Zone lookup and handoff ---
+
+  /**
+   * Get the zone owning a position (positions are clamped to the world)
+   * @returns {World}
+   */
+  zoneAt(x, y) {
+    const zx = Math.max(0, Math.min(this.zonesX - 1, Math.floor(x / this.zoneWidth)));
+    const zy = Math.max(0, Math.min(this.zonesY - 1, Math.floor(y / this.zoneHeight)));
+    return this.zones[zy * this.zonesX + zx];
+  }
+
+  /**
+   * Get the zones whose rectangles overlap a rect
+   * @returns {World[]}
+   */
+  zonesInRect(rect) {
+    return this.zones.filter((zone) => {
+      const b = zone.bounds;
+      return !(rect.x1 < b.x0 || rect.x0 > b.x1 || rect.y1 < b.y0 || rect.y0 > b.y1);
+    });
+  }
+
+  /**
+   * Get the zone simulating an entity
+   * @returns {World|null}
+   */
+  zoneOf(entityId) {
+    return this.entityZones.get(entityId) || null;
+  }
+
+  /**
+   * Hand an entity to the zone that owns its current position, if that changed
+   * @param {Object} entity - Player or Mob
+   * @returns {boolean} - True if the entity changed zones
+   */
+  settle(entity) {
+    const from = this.entityZones.get(entity.id);
+    const to = this.zoneAt(entity.x, entity.y);
+    if (!from || from === to) {
+      return false;
+    }
+    if (!from.detachEntity(entity)) {
+      this.entityZones.delete(entity.id);
+      return false;
+    }
+    to.attachEntity(entity);
+    this.entityZones.set(entity.id, to);
+    this.handoffs++;
+    return true;
+  }
+
+  /**
+   * Run one zone tick, then hand off mobs that wandered across its edge
+   * @param {World} zone - Zone to step
+   */
+  stepZone(zone) {
+    zone.tick();
+    this.collectZoneRemovals(zone);
+    for (const mob of [...zone.mobs.values()]) {
+      if (!zone.ownsPosition(mob.x, mob.y)) {
+        this.settle(mob);
+      }
+    }
+  }
+
+  /**
+   * Advance every zone once (used by tests and single-threaded callers)
+   */
+  step() {
+    for (const zone of this.zones) {
+      this.stepZone(zone);
+    }
+  }
+
+  /**
+   * Start an independent tick loop per zone
+   * @param {number} tickMs - Tick interval
+   */
+  start(tickMs = 100) {
+    this.stop();
+    for (const zone of this.zones) {
+      const timer = setInterval(() => this.stepZone(zone), tickMs);
+      timer.unref();
+      this.timers.push(timer);
+    }
+  }
+
+  stop() {
+    for (const timer of this.timers) {
+      clearInterval(timer);
+    }
+    this.timers = [];
+  }
+
+  /**
+   * Pull players a zone removed on its own (hunter kills) into the shared
+   * disconnect list, and forget mobs it removed (killed in a fight)
+   */
+  collectZoneRemovals(zone) {
+    for (const [name, player] of zone.disconnectedPlayers) {
+      this.disconnectedPlayers.set(name, player);
+      this.entityZones.delete(player.id);
+    }
+    zone.disconnectedPlayers.clear();
+    for (const mobId of zone.removedMobIds) {
+      if (this.entityZones.get(mobId) === zone) {
+        this.entityZones.delete(mobId);
+      }
+    }
+    zone.removedMobIds.length = 0;
+  }
+
+  get ticks() {
+    let ticks = 0;
+    for (const zone of this.zones) {
+      ticks = Math.max(ticks, zone.ticks);
+    }
+    return ticks;
+  }
+
+  // --- World interface: players ---
+
+  addPlayer(player) {
+    if (!player || !player.id) {
+      return false;
+    }
+    const zone = this.zoneAt(player.x, player.y);
+    zone.addPlayer(player);
+    this.entityZones.set(player.id, zone);
+    if (player.name) {
+      this.previousPlayerNames.add(player.name);
+    }
+    this.timestamp = Date.now();
+    return true;
+  }
+
+  removePlayer(playerId) {
+    const zone = this.zoneOf(playerId);
+    if (!zone || !zone.removePlayer(playerId)) {
+      return false;
+    }
+    this.collectZoneRemovals(zone);
+    this.timestamp = Date.now();
+    return true;
+  }
+
+  getPlayer(playerId) {
+    const zone = this.zoneOf(playerId);
+    return zone ? zone.getPlayer(playerId) : null;
+  }
+
+  getAllPlayers() {
+    return this.zones.flatMap(zone => zone.getAllPlayers());
+  }
+
+  getPlayerCount() {
+    return this.zones.reduce((sum, zone) => sum + zone.getPlayerCount(), 0);
+  }
+
+  updatePlayerActivity(playerId) {
+    const zone = this.zoneOf(playerId);
+    if (zone) {
+      zone.updatePlayerActivity(playerId);
+    }
+  }
+
+  cleanupInactivePlayers(timeoutMs = 120000) {
+    const inactive = [];
+    for (const zone of this.zones) {
+      inactive.push(...zone.cleanupInactivePlayers(timeoutMs));
+      this.collectZoneRemovals(zone);
+    }
+    return inactive;
+  }
+
+  isRejoiningPlayer(playerName) {
+    return this.previousPlayerNames.has(playerName);
+  }
+
+  getDisconnectedPlayer(playerName) {
+    for (const zone of this.zones) {
+      this.collectZoneRemovals(zone);
+    }
+    return this.disconnectedPlayers.get(playerName) || null;
+  }
+
+  removeDisconnectedPlayer(playerName) {
+    return this.disconnectedPlayers.delete(playerName);
+  }
+
+  // --- World interface: positions and mobs ---
+
+  isValidPosition(x, y) {
+    return x >= 0 && x < this.width && y >= 0 && y < this.height;
+  }
+
+  getPlayerAtPosition(x, y, excludePlayerId = null) {
+    return this.zoneAt(x, y).getPlayerAtPosition(x, y, excludePlayerId);
+  }
+
+  getMobAtPosition(x, y) {
+    return this.zoneAt(x, y).getMobAtPosition(x, y);
+  }
+
+  getMob(mobId) {
+    const zone = this.zoneOf(mobId);
+    return zone ? zone.getMob(mobId) : null;
+  }
+
+  getAllMobs() {
+    return this.zones.flatMap(zone => zone.getAllMobs());
+  }
+
+  addMob(mob) {
+    if (!mob || !mob.id) {
+      return false;
+    }
+    const zone = this.zoneAt(mob.x, mob.y);
+    zone.addMob(mob);
+    this.entityZones.set(mob.id, zone);
+    return true;
+  }
+
+  removeMob(mobId) {
+    const zone = this.zoneOf(mobId);
+    this.entityZones.delete(mobId);
+    return zone ? zone.removeMob(mobId) : false;
+  }
+
+  /**
+   * Move a player or mob, handing it to the neighbouring zone if it crossed an edge
+   */
+  moveEntity(entity, x, y) {
+    const zone = this.zoneOf(entity.id);
+    if (!zone) {
+      entity.setPosition(x, y);
+      return;
+    }
+    zone.moveEntity(entity, x, y);
+    this.settle(entity);
+  }
+
+  /**
+   * Keep each zone at its share of the mob minimum
+   * @returns {Array} - Newly spawned mobs
+   */
+  respawnMobs(minMobs = 3) {
+    const perZone = Math.ceil(minMobs / this.zones.length);
+    const spawned = [];
+    for (const zone of this.zones) {
+      for (const mob of zone.respawnMobs(perZone)) {
+        this.entityZones.set(mob.id, zone);
+        spawned.push(mob);
+      }
+    }
+    return spawned;
+  }
+
+  // --- World interface: area of interest and state ---
+
+  getViewportRect(centerX, centerY, viewWidth, viewHeight, margin = World.VIEW_MARGIN) {
+    return World.prototype.getViewportRect.call(this, centerX, centerY, viewWidth, viewHeight, margin);
+  }
+
+  /**
+   * Get entities in a rect from every zone it overlaps, so viewers near an
+   * edge also see the border entities of the neighbouring zone
+   */
+  getEntitiesInRect(rect) {
+    const found = [];
+    for (const zone of this.zonesInRect(rect)) {
+      found.push(...zone.getEntitiesInRect(rect));
+    }
+    return [
+      ...found.filter(e => e.type === 'player'),
+      ...found.filter(e => e.type !== 'player')
+    ];
+  }
+
+  /**
+   * Snapshot across zones. Zones advance on their own tick loops, so unlike
+   * World.getState this does not step the simulation.
+   */
+  getState(area = null) {
+    this.adoptNewestZoneMessages();
+    if (this.lastKillMessage && Date.now() - this.lastKillTimestamp > MESSAGE_TTL_MS) {
+      this.clearKillMessage();
+    }
+    const rect = area || { x0: 0, y0: 0, x1: this.width - 1, y1: this.height - 1 };
+    const state = World.prototype.buildState.call(this, this.getEntitiesInRect(rect));
+    state.zones = this.zones.length;
+    return state;
+  }
+
+  /**
+   * Same as getState; there is no shared tick to skip
+   */
+  getSnapshot(area = null) {
+    return this.getState(area);
+  }
+
+  // --- World interface: messages ---
+
+  /**
+   * Zones set kill/combat messages when their mobs fight; surface the newest
+   */
+  adoptNewestZoneMessages() {
+    for (const zone of this.zones) {
+      if (zone.lastKillMessage && zone.lastKillTimestamp > this.lastKillTimestamp) {
+        this.lastKillMessage = zone.lastKillMessage;
+        this.lastKillTimestamp = zone.lastKillTimestamp;
+      }
+      if (zone.lastCombatTimestamp > this.lastCombatTimestamp) {
+        World.prototype.setLastCombat.call(this, {
+          combatLog: zone.lastCombatLog,
+          timestamp: zone.lastCombatTimestamp,
+          finalWinnerName: zone.lastCombatWinner,
+          finalLoserName: zone.lastCombatLoser,
+          finalScore: zone.lastCombatScore,
+          messages: zone.lastCombatMessages
+        });
+      }
+    }
+  }
+
+  setLastCombat(result) {
+    World.prototype.setLastCombat.call(this, result);
+  }
+
+  setKillMessage(winnerName, loserName, loserType) {
+    World.prototype.setKillMessage.call(this, winnerName, loserName, loserType);
+  }
+
+  setRejoinMessage(playerName) {
+    World.prototype.setRejoinMessage.call(this, playerName);
+  }
+
+  setJoinMessage(playerName) {
+    World.prototype.setJoinMessage.call(this, playerName);
+  }
+
+  clearKillMessage() {
+    World.prototype.clearKillMessage.call(this);
+  }
+
+  /**
+   * Reset all zones to their initial state
+   */
+  reset() {
+    for (const zone of this.zones) {
+      zone.reset();
+      zone.disconnectedPlayers.clear();
+      zone.removedMobIds.length = 0;
+    }
+    this.entityZones.clear();
+    this.timestamp = Date.now();
+    this.lastCombatLog = '';
+    this.lastCombatTimestamp = 0;
+    this.lastCombatWinner = '';
+    this.lastCombatLoser = '';
+    this.lastCombatScore = '';
+    this.lastCombatMessages = [];
+    this.lastKillMessage = '';
+    this.lastKillTimestamp = 0;
+  }
+}
+
+module.exports = ZoneManager;
@@ -4,6 +4,7 @@
 
 const request = require('supertest');
 const { app, world } = require('../src/server');
+const Player = require('../src/player');
 
 describe('API Endpoints', () => {
   beforeEach(() => {
@@ -36,6 +37,18 @@ describe('API Endpoints', () => {
     });
   });
 
+  describe('GET /api/metrics', () => {
+    test('reports TCP connection metrics', async () => {
+      const res = await request(app)
+        .get('/api/metrics')
+        .expect(200);
+
+      expect(res.body.success).toBe(true);
+      expect(res.body.tcp.connections).toEqual([]);
+      expect(res.body.tcp.meanRttMs).toBe(0);
+    });
+  });
+
   describe('GET /api/world/state', () => {
     test('returns world state', async () => {
       const res = await request(app)
@@ -65,6 +78,31 @@ describe('API Endpoints', () => {
     });
   });
 
+  describe('GET /api/world/state with viewport', () => {
+    test('limits entities to the area around the viewer', async () => {
+      world.addPlayer(new Player('viewer', 'Viewer', 5, 5));
+      world.addPlayer(new Player('near', 'Near', 7, 6));
+      world.addPlayer(new Player('far', 'Far', 35, 18));
+
+      const res = await request(app)
+        .get('/api/world/state?playerId=viewer&viewWidth=10&viewHeight=6')
+        .expect(200);
+
+      const ids = res.body.players.map(p => p.id).sort();
+      expect(ids).toEqual(['near', 'viewer']);
+    });
+
+    test('ignores the viewport for unknown players', async () => {
+      world.addPlayer(new Player('far', 'Far', 35, 18));
+
+      const res = await request(app)
+        .get('/api/world/state?playerId=nobody&viewWidth=10&viewHeight=6')
+        .expect(200);
+
+      expect(res.body.players.length).toBe(1);
+    });
+  });
+
   describe('POST /api/player/join', () => {
     test('creates new player', async () => {
       const res = await request(app)
@@ -0,0 +1,64 @@
+/**
+ * Arena Manager Tests
+ *
+ * Runs real worker threads.
+ */
+
+const ArenaManager = require('../src/arena_manager');
+
+describe('ArenaManager', () => {
+  let arenas;
+
+  beforeEach(() => {
+    arenas = new ArenaManager({ workers: 2, maxPlayers: 2, minMobs: 0, tickMs: 20 });
+    arenas.start();
+  });
+
+  afterEach(async () => {
+    await arenas.stop();
+  });
+
+  test('fills an arena before opening the next', async () => {
+    const a = await arenas.join('Alice');
+    const b = await arenas.join('Bob');
+    const c = await arenas.join('Carol');
+
+    expect(a.arenaId).toBe(b.arenaId);
+    expect(c.arenaId).not.toBe(a.arenaId);
+    expect(a.player.name).toBe('Alice');
+  });
+
+  test('opens new arenas on the least loaded worker', async () => {
+    await Promise.all(['A', 'B', 'C', 'D'].map(name => arenas.join(name)));
+
+    const { workers, arenas: list } = arenas.getStats();
+    expect(list.length).toBe(2);
+    expect(workers.map(w => w.arenas)).toEqual([1, 1]);
+  });
+
+  test('moves a player and reports it in arena state', async () => {
+    const { arenaId, player } = await arenas.join('Alice');
+    const direction = player.x > 0 ? 'left' : 'right';
+
+    const moved = await arenas.move(arenaId, player.id, direction);
+    expect(moved.collision).toBe(false);
+    expect(moved.x).toBe(player.x + (direction === 'left' ? -1 : 1));
+
+    const state = await arenas.getState(arenaId, player.id);
+    expect(state.players.map(e => [e.id, e.x, e.y])).toEqual([[player.id, moved.x, moved.y]]);
+  });
+
+  test('advances arenas on the worker without state requests', async () => {
+    const { arenaId } = await arenas.join('Alice');
+    await new Promise((resolve) => setTimeout(resolve, 100));
+    expect((await arenas.getState(arenaId)).ticks).toBeGreaterThan(0);
+  });
+
+  test('closes an arena when its last player leaves', async () => {
+    const { arenaId, player } = await arenas.join('Alice');
+    expect(await arenas.leave(arenaId, player.id)).toBe(true);
+
+    expect(arenas.getStats().arenas).toEqual([]);
+    expect(await arenas.getState(arenaId)).toBeNull();
+  });
+});
@@ -0,0 +1,148 @@
+/**
+ * Client Outbox Tests
+ */
+
+const EventEmitter = require('events');
+const ClientOutbox = require('../src/client_outbox');
+
+// Socket stand-in whose kernel buffer never drains unless told to. Like a
+// net.Socket, it only emits 'drain' after a write() that returned false.
+class FakeSocket extends EventEmitter {
+  constructor(highWaterMark = 50) {
+    super();
+    this.writableHighWaterMark = highWaterMark;
+    this.writableLength = 0;
+    this.written = [];
+    this.callbacks = [];
+    this.needDrain = false;
+    this.destroyed = false;
+  }
+
+  write(buf, callback) {
+    this.written.push(buf);
+    this.writableLength += buf.length;
+    if (callback) {
+      this.callbacks.push(callback);
+    }
+    const ok = this.writableLength < this.writableHighWaterMark;
+    if (!ok) {
+      this.needDrain = true;
+    }
+    return ok;
+  }
+
+  // Hand everything buffered to the kernel
+  drain() {
+    const callbacks = this.callbacks;
+    this.writableLength = 0;
+    this.callbacks = [];
+    callbacks.forEach((callback) => callback());
+    if (this.needDrain) {
+      this.needDrain = false;
+      this.emit('drain');
+    }
+  }
+
+  // Empty the buffer with no write callbacks or 'drain' (they were missed)
+  empty() {
+    this.writableLength = 0;
+    this.callbacks = [];
+  }
+
+  destroy() {
+    this.destroyed = true;
+  }
+}
+
+describe('ClientOutbox', () => {
+  let socket;
+  let outbox;
+
+  beforeEach(() => {
+    socket = new FakeSocket();
+    outbox = new ClientOutbox(socket, {
+      snapshotHighWaterBytes: 10,
+      maxBufferedBytes: 100,
+      stallTimeoutMs: 1000
+    });
+  });
+
+  test('writes snapshots directly while the client keeps up', () => {
+    outbox.sendSnapshot(Buffer.alloc(5));
+    expect(socket.written.length).toBe(1);
+    expect(outbox.getStats().snapshotPending).toBe(false);
+  });
+
+  test('keeps only the newest snapshot once the client falls behind', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    outbox.sendSnapshot(Buffer.from('old'));
+    outbox.sendSnapshot(Buffer.from('new'));
+
+    expect(socket.written.length).toBe(1);
+    expect(outbox.getStats().snapshotsReplaced).toBe(1);
+
+    socket.drain();
+    expect(socket.written.length).toBe(2);
+    expect(socket.written[1].toString()).toBe('new');
+    expect(outbox.getStats().snapshotPending).toBe(false);
+  });
+
+  test('sends a held snapshot when a backlog below the socket high-water mark empties', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    outbox.sendSnapshot(Buffer.from('held'));
+    expect(socket.needDrain).toBe(false);
+
+    socket.drain();
+    expect(socket.written.length).toBe(2);
+    expect(socket.written[1].toString()).toBe('held');
+    expect(outbox.getStats().snapshotPending).toBe(false);
+  });
+
+  test('sends a held snapshot after a backlog past the socket high-water mark', () => {
+    outbox.send(Buffer.alloc(60));
+    outbox.sendSnapshot(Buffer.from('held'));
+    expect(socket.needDrain).toBe(true);
+
+    socket.drain();
+    expect(socket.written[1].toString()).toBe('held');
+    expect(outbox.getStats().snapshotPending).toBe(false);
+  });
+
+  test('flush sends a held snapshot once the socket has emptied', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    outbox.sendSnapshot(Buffer.from('held'));
+    socket.empty();
+
+    expect(outbox.flush()).toBe(true);
+    expect(socket.written[1].toString()).toBe('held');
+    expect(outbox.backloggedSince).toBe(0);
+  });
+
+  test('always writes reliable packets', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    outbox.send(Buffer.alloc(4));
+    expect(socket.written.length).toBe(2);
+  });
+
+  test('disconnects a client past the byte limit', () => {
+    expect(outbox.send(Buffer.alloc(150))).toBe(false);
+    expect(socket.destroyed).toBe(true);
+    expect(outbox.send(Buffer.alloc(1))).toBe(false);
+  });
+
+  test('disconnects a client backlogged past the stall timeout', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    const since = outbox.backloggedSince;
+    expect(since).toBeGreaterThan(0);
+
+    expect(outbox.checkLimits(since + 500)).toBe(true);
+    expect(outbox.checkLimits(since + 1500)).toBe(false);
+    expect(socket.destroyed).toBe(true);
+  });
+
+  test('clears the backlog timer once the socket drains', () => {
+    outbox.sendSnapshot(Buffer.alloc(20));
+    socket.drain();
+    expect(outbox.backloggedSince).toBe(0);
+  });
+});
@@ -0,0 +1,167 @@
+/**
+ * IO Pool Tests
+ *
+ * Runs real IO worker threads against a world on the test thread.
+ */
+
+const net = require('net');
+const World = require('../src/world');
+const GameRules = require('../src/game_rules');
+const IoPool = require('../src/io_pool');
+const SharedWorldClient = require('../src/shared_world_client');
+const SpscRing = require('../src/spsc_ring');
+
+// Collects bytes from a socket until at least `len` are available
+function reader(socket) {
+  let buffer = Buffer.alloc(0);
+  let waiter = null;
+  socket.on('data', (data) => {
+    buffer = Buffer.concat([buffer, data]);
+    if (waiter) waiter();
+  });
+  return (len) => new Promise((resolve) => {
+    const check = () => {
+      if (buffer.length >= len) {
+        waiter = null;
+        const out = buffer.subarray(0, len);
+        buffer = buffer.subarray(len);
+        resolve(out);
+      }
+    };
+    waiter = check;
+    check();
+  });
+}
+
+describe('IoPool', () => {
+  let world;
+  let pool;
+  let ports;
+  let sockets;
+
+  beforeEach(async () => {
+    world = new World(40, 20);
+    pool = new IoPool(world, { workers: 2, port: 0, reusePort: false, tickMs: 20 });
+    ports = await pool.start();
+    sockets = [];
+  });
+
+  afterEach(async () => {
+    sockets.forEach(s => s.destroy());
+    await pool.stop();
+  });
+
+  function connect(port) {
+    const socket = net.connect(port);
+    sockets.push(socket);
+    return new Promise((resolve) => socket.once('connect', () => resolve(socket)));
+  }
+
+  test('workers accept on one shared port', () => {
+    expect(ports.length).toBe(2);
+    expect(ports[0]).toBe(ports[1]);
+  });
+
+  test('joins through a worker and serves state from the shared snapshot', async () => {
+    const socket = await connect(ports[1]);
+    const read = reader(socket);
+    socket.write(Buffer.from([0x01, 5, ...Buffer.from('Alice')]));
+
+    const head = await read(2);
+    expect(head[0]).toBe(0x01);
+    const rest = await read(head[1] + 2 + 1 + 1);
+    await read(rest[rest.length - 1]); // Version string
+    expect(world.getAllPlayers().map(p => p.name)).toEqual(['Alice']);
+
+    // Wait for a tick to publish, then read state: 0x03 [Count] [TicksLo] [TicksHi] [MsgLen] [Msg] [Type X Y]...
+    await new Promise((resolve) => setTimeout(resolve, 50));
+    socket.write(Buffer.from([0x03]));
+    const state = await read(5);
+    expect(state[0]).toBe(0x03);
+    expect(state[1]).toBe(1);
+    const body = await read(state[4] + 3);
+    expect(String.fromCharCode(body[state[4]])).toBe('M');
+    expect(body[state[4] + 1]).toBe(world.getAllPlayers()[0].x);
+  });
+
+  test('applies moves on the simulation thread', async () => {
+    const socket = await connect(ports[0]);
+    const read = reader(socket);
+    socket.write(Buffer.from([0x01, 3, ...Buffer.from('Bob')]));
+    const head = await read(2);
+    const rest = await read(head[1] + 4);
+    await read(rest[rest.length - 1]);
+
+    const player = world.getAllPlayers()[0];
+    world.moveEntity(player, 10, 10);
+    socket.write(Buffer.from([0x02, 'r'.charCodeAt(0)]));
+    const moved = await read(6);
+    expect(moved[0]).toBe(0x02);
+    expect(moved[1]).toBe(11);
+    expect(player.x).toBe(11);
+  });
+
+  test('merges connection metrics from every worker', async () => {
+    // Which worker accepts each connection is up to the kernel
+    await Promise.all([...Array(8).keys()].map(() => connect(ports[0])));
+    await new Promise((resolve) => setTimeout(resolve, 50));
+
+    const stats = await pool.getStats();
+    expect(stats.workersReporting).toBe(2);
+    expect(stats.connections.length).toBe(8);
+    stats.connections.forEach(c => expect([0, 1]).toContain(c.worker));
+    expect(stats.meanRttMs).toBe(0);
+  });
+});
+
+describe('IoPool reply ring', () => {
+  test('keeps replies the ring has no room for and delivers them once the worker drains', async () => {
+    const pool = new IoPool(new World(40, 20));
+    const slot = {
+      index: 0,
+      toSim: new SpscRing(1024),
+      fromSim: new SpscRing(64), // Room for 8 LEAVE replies
+      replyBacklog: [],
+      retryTimer: null,
+      worker: { postMessage: () => {} }
+    };
+    for (let requestId = 1; requestId <= 20; requestId++) {
+      const msg = Buffer.alloc(9);
+      msg[0] = SharedWorldClient.OPS.LEAVE;
+      msg.writeUInt32LE(requestId, 1);
+      slot.toSim.push(msg);
+    }
+    pool.drain(slot, false);
+    expect(slot.replyBacklog.length).toBe(12);
+
+    const received = [];
+    while (received.length < 20) {
+      let reply;
+      while ((reply = slot.fromSim.pop()) !== null) {
+        received.push(reply.readUInt32LE(1));
+      }
+      await new Promise((resolve) => setTimeout(resolve, 5));
+    }
+    expect(received).toEqual([...Array(20).keys()].map(i => i + 1));
+    expect(slot.replyBacklog.length).toBe(0);
+  });
+});
+
+describe('IoPool handles', () => {
+  test('gives players joined outside the rings their own handles', () => {
+    const world = new World(40, 20);
+    const pool = new IoPool(world);
+    const alice = GameRules.joinPlayer(world, 'Alice').player;
+    GameRules.joinPlayer(world, 'Bob');
+    pool.publish();
+
+    const handles = pool.snapshot.read().entities.filter(e => e.kind === 1).map(e => e.handle);
+    expect(handles.length).toBe(2);
+    expect(handles).not.toContain(0);
+    expect(new Set(handles).size).toBe(2);
+
+    world.removePlayer(alice.id);
+    pool.pruneHandles();
+    expect(pool.handles.has(alice.id)).toBe(false);
+  });
+});
@@ -0,0 +1,63 @@
+/**
+ * Shared Snapshot Tests
+ */
+
+const SharedSnapshot = require('../src/shared_snapshot');
+const World = require('../src/world');
+const Player = require('../src/player');
+const Mob = require('../src/mob');
+
+describe('SharedSnapshot', () => {
+  let world;
+
+  beforeEach(() => {
+    world = new World(300, 200);
+    world.addPlayer(new Player('p1', 'Alice', 250, 150));
+    world.addMob(new Mob('m1', 'Hunter', 3, 4, true));
+  });
+
+  test('returns null before the first publish', () => {
+    expect(new SharedSnapshot(16).read()).toBeNull();
+  });
+
+  test('round-trips entities through a second view of the buffer', () => {
+    const writer = new SharedSnapshot(16);
+    world.setJoinMessage('Alice');
+    writer.write(world, () => 7);
+
+    const snap = new SharedSnapshot(writer.buffer).read();
+    expect(snap.width).toBe(300);
+    expect(snap.message).toBe('Alice joined the game!');
+    expect(snap.entities).toEqual([
+      { kind: SharedSnapshot.KIND_PLAYER, handle: 7, x: 250, y: 150 },
+      { kind: SharedSnapshot.KIND_HUNTER, handle: 1, x: 3, y: 4 }
+    ]);
+  });
+
+  test('keeps each mob\'s handle while it lives', () => {
+    const writer = new SharedSnapshot(16);
+    world.addMob(new Mob('m2', 'Goblin', 5, 6));
+    writer.write(world, () => 7);
+    world.removeMob('m1');
+    world.addMob(new Mob('m3', 'Goblin', 7, 8));
+    writer.write(world, () => 7);
+
+    expect(writer.read().entities.map(e => e.handle)).toEqual([7, 2, 3]);
+  });
+
+  test('truncates to capacity', () => {
+    const writer = new SharedSnapshot(1);
+    writer.write(world, () => 1);
+    expect(writer.read().entities.length).toBe(1);
+  });
+
+  test('falls back to the last good copy while a write is in progress', () => {
+    const snapshot = new SharedSnapshot(16);
+    snapshot.write(world, () => 1);
+    const good = snapshot.read();
+
+    Atomics.add(snapshot.header, 0, 1); // Writer stalled mid-update
+    world.players.get('p1').x = 9;
+    expect(snapshot.read()).toBe(good);
+  });
+});
@@ -0,0 +1,48 @@
+/**
+ * Shared World Client Tests
+ */
+
+const SharedSnapshot = require('../src/shared_snapshot');
+const SharedWorldClient = require('../src/shared_world_client');
+const TcpServer = require('../src/tcp_server');
+const World = require('../src/world');
+const Player = require('../src/player');
+const Mob = require('../src/mob');
+
+describe('SharedWorldClient', () => {
+  let world;
+  let snapshot;
+  let client;
+
+  beforeEach(() => {
+    world = new World(40, 20);
+    world.addPlayer(new Player('p1', 'Alice', 1, 1));
+    world.addMob(new Mob('m1', 'Goblin', 3, 3));
+    world.addMob(new Mob('m2', 'Goblin', 5, 5));
+    world.addMob(new Mob('m3', 'Hunter', 7, 7, true));
+    snapshot = new SharedSnapshot(16);
+    snapshot.write(world, () => 1);
+    client = new SharedWorldClient(new SharedSnapshot(snapshot.buffer), null, null, () => {});
+    client.handles.set('p1', 1);
+  });
+
+  test('gives every entity its own id', async () => {
+    const state = await client.getState(0, 'p1');
+    const ids = state.players.map(p => p.id);
+    expect(ids[0]).toBe('p1');
+    expect(new Set(ids).size).toBe(4);
+  });
+
+  test('keeps NUMERIC_IDS numbers stable as mobs come and go', async () => {
+    const tcp = Object.create(TcpServer.prototype);
+    const socket = { codec: { entityIds: new Map(), nextEntityId: 0 } };
+
+    const first = tcp.entityNumbers(socket, (await client.getState(0, 'p1')).players);
+    expect(first).toEqual([1, 2, 3, 4]);
+
+    world.removeMob('m1');
+    snapshot.write(world, () => 1);
+    const second = tcp.entityNumbers(socket, (await client.getState(0, 'p1')).players);
+    expect(second).toEqual([1, 3, 4]);
+  });
+});
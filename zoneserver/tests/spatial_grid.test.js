@@ -0,0 +1,56 @@
+/**
+ * Spatial Grid Tests
+ */
+
+const SpatialGrid = require('../src/spatial_grid');
+
+describe('SpatialGrid', () => {
+  let grid;
+
+  beforeEach(() => {
+    grid = new SpatialGrid(8);
+  });
+
+  test('finds entities inside a rect', () => {
+    const a = { x: 1, y: 1 };
+    const b = { x: 20, y: 10 };
+    grid.insert(a);
+    grid.insert(b);
+
+    expect(grid.queryRect(0, 0, 9, 9)).toEqual([a]);
+    expect(grid.queryRect(15, 5, 25, 15)).toEqual([b]);
+  });
+
+  test('excludes entities in overlapping cells but outside the rect', () => {
+    grid.insert({ x: 7, y: 7 });
+    expect(grid.queryRect(0, 0, 5, 5).length).toBe(0);
+  });
+
+  test('re-buckets moved entities', () => {
+    const a = { x: 1, y: 1 };
+    grid.insert(a);
+    a.x = 30;
+    grid.update(a);
+
+    expect(grid.queryRect(0, 0, 7, 7).length).toBe(0);
+    expect(grid.queryRect(24, 0, 31, 7)).toEqual([a]);
+  });
+
+  test('finds entities at an exact position', () => {
+    const a = { x: 3, y: 4 };
+    grid.insert(a);
+    grid.insert({ x: 4, y: 4 });
+
+    expect(grid.getAt(3, 4)).toEqual([a]);
+    expect(grid.getAt(100, 100)).toEqual([]);
+  });
+
+  test('drops empty cells on removal', () => {
+    const a = { x: 1, y: 1 };
+    grid.insert(a);
+    expect(grid.remove(a)).toBe(true);
+    expect(grid.cells.size).toBe(0);
+    expect(grid.size).toBe(0);
+    expect(grid.remove(a)).toBe(false);
+  });
+});
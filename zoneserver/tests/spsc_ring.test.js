@@ -0,0 +1,50 @@
+/**
+ * SPSC Ring Tests
+ */
+
+const SpscRing = require('../src/spsc_ring');
+
+describe('SpscRing', () => {
+  test('delivers messages in order', () => {
+    const ring = new SpscRing(64);
+    expect(ring.push(Buffer.from('one'))).toBe(true);
+    expect(ring.push(Buffer.from('two'))).toBe(true);
+
+    expect(ring.pop().toString()).toBe('one');
+    expect(ring.pop().toString()).toBe('two');
+    expect(ring.pop()).toBeNull();
+    expect(ring.isEmpty()).toBe(true);
+  });
+
+  test('refuses a message that does not fit', () => {
+    const ring = new SpscRing(64);
+    expect(ring.push(Buffer.alloc(40))).toBe(true);
+    expect(ring.push(Buffer.alloc(40))).toBe(false);
+    ring.pop();
+    expect(ring.push(Buffer.alloc(40))).toBe(true);
+  });
+
+  test('wraps messages around the end of the buffer', () => {
+    const ring = new SpscRing(64);
+    for (let i = 0; i < 50; i++) {
+      const msg = Buffer.from([i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6]);
+      expect(ring.push(msg)).toBe(true);
+      expect([...ring.pop()]).toEqual([...msg]);
+    }
+  });
+
+  test('shares state through the buffer', () => {
+    const producer = new SpscRing(64);
+    const consumer = new SpscRing(producer.buffer);
+    producer.push(Buffer.from('hi'));
+    expect(consumer.pop().toString()).toBe('hi');
+  });
+
+  test('claims one kick per batch until the consumer re-arms', () => {
+    const ring = new SpscRing(64);
+    expect(ring.claimKick()).toBe(true);
+    expect(ring.claimKick()).toBe(false);
+    ring.clearKick();
+    expect(ring.claimKick()).toBe(true);
+  });
+});
@@ -0,0 +1,650 @@
+/**
+ * TCP Server Protocol Tests
+ *
+ * Drives the binary protocol over a real loopback socket.
+ */
+
+const net = require('net');
+const World = require('../src/world');
+const Player = require('../src/player');
+const TcpServer = require('../src/tcp_server');
+const ArenaManager = require('../src/arena_manager');
+
+// Byte length of the complete response at the start of buf, or 0 if incomplete
+function responseLength(buf, coord, framed = false) {
+  if (buf.length < 1) return 0;
+  if (framed) {
+    return buf.length >= 3 ? 3 + buf.readUInt16LE(1) : 0;
+  }
+  switch (buf[0]) {
+    case 0x01: {
+      if (buf.length < 2) return 0;
+      const verAt = 2 + buf[1] + coord * 2 + 1;
+      return buf.length > verAt ? verAt + 1 + buf[verAt] : 0;
+    }
+    case 0x02: {
+      const msgAt = 1 + coord * 2 + 2;
+      return buf.length > msgAt ? msgAt + 1 + buf[msgAt] : 0;
+    }
+    case 0x03:
+      return buf.length >= 5 ? 5 + buf[4] + buf[1] * (1 + coord * 2) : 0;
+    case 0x05:
+      return 6;
+    case 0x06: {
+      if (buf.length < 4) return 0;
+      const verAt = 4 + buf[3] + coord * 2 + 1;
+      return buf.length > verAt ? verAt + 1 + buf[verAt] : 0;
+    }
+    case 0x0A:
+      return 10;
+    case 0x0B: {
+      const msgAt = 2 + coord * 2 + 2;
+      return buf.length > msgAt ? msgAt + 1 + buf[msgAt] : 0;
+    }
+    case 0x07:
+    case 0x08:
+    case 0x09:
+      return buf.length >= 3 ? 3 + buf.readUInt16LE(1) : 0;
+    default:
+      throw new Error(`Unexpected response type ${buf[0]}`);
+  }
+}
+
+class TestClient {
+  constructor(port) {
+    this.socket = net.connect(port);
+    this.buffer = Buffer.alloc(0);
+    this.waiters = [];
+    this.coord = 1; // Bytes per coordinate
+    this.framed = false; // Every reply carries a length after its type
+    this.socket.on('data', (data) => {
+      this.buffer = Buffer.concat([this.buffer, data]);
+      this.pump();
+    });
+  }
+
+  pump() {
+    while (this.waiters.length > 0) {
+      const len = responseLength(this.buffer, this.coord, this.framed);
+      if (len === 0 || this.buffer.length < len) return;
+      const packet = this.buffer.subarray(0, len);
+      this.buffer = this.buffer.subarray(len);
+      this.waiters.shift()(packet);
+    }
+  }
+
+  next() {
+    return new Promise((resolve) => {
+      this.waiters.push(resolve);
+      this.pump();
+    });
+  }
+
+  send(bytes) {
+    this.socket.write(Buffer.from(bytes));
+  }
+
+  join(name) {
+    this.send([0x01, name.length, ...Buffer.from(name)]);
+    return this.next();
+  }
+
+  close() {
+    this.socket.destroy();
+  }
+}
+
+function parseState(packet, coord = 1, ids = false) {
+  const msgLen = packet[4];
+  const entities = [];
+  const read = (off) => (coord === 2 ? packet.readUInt16LE(off) : packet[off]);
+  const idLen = ids ? 2 : 0;
+  for (let i = 0, off = 5 + msgLen; i < packet[1]; i++, off += 1 + idLen + coord * 2) {
+    const ent = { type: String.fromCharCode(packet[off]), x: read(off + 1 + idLen), y: read(off + 1 + idLen + coord) };
+    if (ids) {
+      ent.id = packet.readUInt16LE(off + 1);
+    }
+    entities.push(ent);
+  }
+  return entities;
+}
+
+// Decode a packed 0x07 state packet; runs copy records from prev
+function parsePacked(packet, prev = [], ids = false) {
+  let off = 3;
+  let count = 0;
+  for (let shift = 0; ; shift += 7) {
+    const b = packet[off++];
+    count |= (b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  const ticks = packet.readUInt16LE(off);
+  const msgLen = packet[off + 2];
+  const message = packet.subarray(off + 3, off + 3 + msgLen).toString();
+  off += 3 + msgLen;
+  const xBits = packet[off];
+  const yBits = packet[off + 1];
+  const idBits = ids ? packet[off + 2] : 0;
+  let bitPos = (off + (ids ? 3 : 2)) * 8;
+  const read = (n) => {
+    let v = 0;
+    for (let i = 0; i < n; i++, bitPos++) {
+      v = (v << 1) | ((packet[bitPos >> 3] >> (7 - (bitPos & 7))) & 1);
+    }
+    return v;
+  };
+
+  const entities = [];
+  let runs = 0;
+  while (entities.length < count) {
+    if (read(1)) {
+      runs++;
+      for (let n = read(4) + 1; n > 0; n--) {
+        entities.push(prev[entities.length]);
+      }
+    } else {
+      const type = TcpServer.PACKED_TYPES[read(2)];
+      const id = read(idBits);
+      const ent = { type, x: read(xBits), y: read(yBits) };
+      if (ids) {
+        ent.id = id;
+      }
+      entities.push(ent);
+    }
+  }
+  return { ticks, message, entities, runs };
+}
+
+// Split a 0x08 connect reply into its fields and embedded state packet
+function parseConnect(packet) {
+  const caps = packet.readUInt16LE(4);
+  const coord = caps & TcpServer.CAPS.WIDE_COORDS ? 2 : 1;
+  const idLen = packet[10];
+  const posAt = 11 + idLen;
+  const verAt = posAt + coord * 2 + 1;
+  let off = verAt + 1 + packet[verAt];
+  let token = null;
+  if (caps & TcpServer.CAPS.RESUME) {
+    token = packet.subarray(off + 1, off + 1 + packet[off]);
+    off += 1 + packet[off];
+  }
+  return {
+    version: packet[3],
+    caps,
+    width: packet.readUInt16LE(6),
+    height: packet.readUInt16LE(8),
+    id: packet.subarray(11, 11 + idLen).toString(),
+    x: coord === 2 ? packet.readUInt16LE(posAt) : packet[posAt],
+    y: coord === 2 ? packet.readUInt16LE(posAt + coord) : packet[posAt + coord],
+    token,
+    state: packet.subarray(off)
+  };
+}
+
+function resumePacket(caps, ticks, count, token) {
+  return [0x09, 9, caps & 0xFF, caps >> 8, 40, 20, ticks & 0xFF, ticks >> 8, count & 0xFF, count >> 8,
+    token.length, ...token];
+}
+
+function connectPacket(version, caps, name) {
+  return [0x08, version, caps & 0xFF, caps >> 8, 40, 20, name.length, ...Buffer.from(name)];
+}
+
+describe('TcpServer', () => {
+  let world;
+  let tcp;
+  let port;
+  let client;
+
+  beforeEach((done) => {
+    world = new World(40, 20);
+    tcp = new TcpServer(world, 0);
+    tcp.server.once('listening', () => {
+      port = tcp.server.address().port;
+      client = new TestClient(port);
+      client.socket.once('connect', () => done());
+    });
+    tcp.start();
+  });
+
+  afterEach((done) => {
+    client.close();
+    tcp.stop(() => done());
+  });
+
+  test('joins and reports the player in state', async () => {
+    const joined = await client.join('Alice');
+    expect(joined[0]).toBe(0x01);
+
+    client.send([0x03]);
+    const state = parseState(await client.next());
+    expect(state.length).toBe(1);
+    expect(state[0].type).toBe('M');
+  });
+
+  test('handles packets coalesced into one write', async () => {
+    const name = Buffer.from('Bob');
+    client.send([0x01, name.length, ...name, 0x04, 40, 20, 0x03]);
+    expect((await client.next())[0]).toBe(0x01);
+    expect((await client.next())[0]).toBe(0x03);
+  });
+
+  test('handles a packet split across writes', async () => {
+    client.send([0x01, 5, 0x43]);
+    await new Promise((resolve) => setTimeout(resolve, 20));
+    client.send([0x61, 0x72, 0x6f, 0x6c]);
+    expect((await client.next())[0]).toBe(0x01);
+    expect(world.getAllPlayers()[0].name).toBe('Carol');
+  });
+
+  test('filters state to the declared viewport', async () => {
+    world = new World(200, 100);
+    tcp.world = world;
+    world.addPlayer(new Player('far', 'Far', 190, 90));
+
+    await client.join('Alice');
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 20, 10);
+    world.addPlayer(new Player('near', 'Near', 25, 12));
+
+    client.send([0x03]);
+    expect(parseState(await client.next()).length).toBe(3);
+
+    client.send([0x04, 40, 20, 0x03]);
+    const visible = parseState(await client.next());
+    expect(visible.map(e => e.type).sort()).toEqual(['M', 'P']);
+  });
+
+  test('negotiates 16-bit coordinates with a hello', async () => {
+    world = new World(1000, 800);
+    tcp.world = world;
+
+    client.send([0x05, 2]);
+    const hello = await client.next();
+    expect(hello[1]).toBe(2);
+    expect(hello.readUInt16LE(2)).toBe(1000);
+    expect(hello.readUInt16LE(4)).toBe(800);
+    client.coord = 2;
+
+    await client.join('Alice');
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 500, 700);
+
+    client.send([0x02, 'r'.charCodeAt(0)]);
+    const moved = await client.next();
+    expect(moved.readUInt16LE(1)).toBe(501);
+    expect(moved.readUInt16LE(3)).toBe(700);
+
+    client.send([0x03]);
+    const state = parseState(await client.next(), 2);
+    expect(state).toEqual([{ type: 'M', x: 501, y: 700 }]);
+  });
+
+  test('sends packed state with runs for unchanged entities', async () => {
+    client.send([0x05, 9]);
+    expect((await client.next())[1]).toBe(TcpServer.PROTOCOL_VERSION);
+    client.coord = 2;
+
+    await client.join('Alice');
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 5, 5);
+    world.mobs.clear();
+    world.addPlayer(new Player('p2', 'Bob', 30, 15));
+    world.addPlayer(new Player('p3', 'Carol', 39, 19));
+    world.tick = () => {}; // Keep the mobs out of it
+    world.lastKillMessage = '';
+
+    client.send([0x03]);
+    const first = await client.next();
+    const full = parsePacked(first);
+    expect(full.runs).toBe(0);
+    expect(full.entities.map(e => `${e.type}${e.x},${e.y}`).sort()).toEqual(['M5,5', 'P30,15', 'P39,19']);
+    // 0x03 would need 5 bytes per record at 16-bit coordinates; packed they are 14 bits
+    expect(first.length).toBeLessThan(5 + 3 * 5);
+
+    client.send([0x02, 'r'.charCodeAt(0)]);
+    await client.next();
+    client.send([0x03]);
+    const second = parsePacked(await client.next(), full.entities);
+    expect(second.runs).toBeGreaterThan(0);
+    expect(second.entities.map(e => `${e.type}${e.x},${e.y}`).sort()).toEqual(['M6,5', 'P30,15', 'P39,19']);
+  });
+
+  test('negotiates capabilities in a 0x06 join', async () => {
+    const { CAPS } = TcpServer;
+    const name = Buffer.from('Alice');
+    client.coord = 2;
+    client.send([0x06, CAPS.WIDE_COORDS | CAPS.DELTA | CAPS.PUSH, 0x80, name.length, ...name]);
+    const joined = await client.next();
+    // Unknown bits and DELTA without PACKED are refused
+    expect(joined.readUInt16LE(1)).toBe(CAPS.WIDE_COORDS);
+    expect(joined.subarray(4, 4 + joined[3]).toString()).toBe(world.getAllPlayers()[0].id);
+
+    client.send([0x03]);
+    const state = await client.next();
+    expect(state[0]).toBe(0x03);
+    expect(parseState(state, 2).map(e => e.type)).toContain('M');
+  });
+
+  test('grants packed state to a client that asks for it', async () => {
+    const { CAPS } = TcpServer;
+    const name = Buffer.from('Bob');
+    const wanted = CAPS.WIDE_COORDS | CAPS.PACKED | CAPS.DELTA;
+    client.send([0x06, wanted, 0, name.length, ...name]);
+    client.coord = 2;
+    expect((await client.next()).readUInt16LE(1)).toBe(wanted);
+
+    client.send([0x03]);
+    expect((await client.next())[0]).toBe(0x07);
+  });
+
+  test('connects, joins and sends the first snapshot in one reply', async () => {
+    client.send(connectPacket(9, 0xFFFF, 'Alice'));
+    const reply = parseConnect(await client.next());
+
+    expect(reply.version).toBe(TcpServer.PROTOCOL_VERSION);
+    expect(reply.caps).toBe(TcpServer.SERVER_CAPS);
+    expect([reply.width, reply.height]).toEqual([40, 20]);
+    expect(reply.id).toBe(world.getAllPlayers()[0].id);
+    expect(reply.state[0]).toBe(0x07);
+    expect(parsePacked(reply.state).entities.map(e => e.type)).toContain('M');
+
+    // The connect declared the viewport and the snapshot is the run base
+    const socket = tcp.clients.values().next().value;
+    expect(socket.viewport).toEqual({ width: 40, height: 20 });
+    expect(socket.codec.packedBase.length).toBe(parsePacked(reply.state).entities.length);
+  });
+
+  test('connect falls back to 0x03 state for clients without packed caps', async () => {
+    client.send(connectPacket(1, 0, 'Bob'));
+    const reply = parseConnect(await client.next());
+    expect(reply.version).toBe(1);
+    expect(reply.caps).toBe(0);
+    expect(reply.state[0]).toBe(0x03);
+    expect(parseState(reply.state).map(e => e.type)).toContain('M');
+  });
+
+  test('frames every reply once FRAMED is granted', async () => {
+    const { CAPS } = TcpServer;
+    client.send(connectPacket(9, CAPS.WIDE_COORDS | CAPS.FRAMED, 'Alice'));
+    const reply = parseConnect(await client.next());
+    expect(reply.caps).toBe(CAPS.WIDE_COORDS | CAPS.FRAMED);
+    client.framed = true;
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 10, 10);
+
+    client.send([0x02, 'd'.charCodeAt(0)]);
+    const moved = await client.next();
+    expect(moved[0]).toBe(0x02);
+    expect(moved.readUInt16LE(1)).toBe(moved.length - 3);
+    expect(moved.readUInt16LE(3)).toBe(10);
+    expect(moved.readUInt16LE(5)).toBe(11);
+
+    client.send([0x03]);
+    const framed = await client.next();
+    expect(framed[0]).toBe(0x03);
+    // Dropping the length leaves a plain 0x03 packet
+    const state = parseState(Buffer.concat([framed.subarray(0, 1), framed.subarray(3)]), 2);
+    expect(state.find(e => e.type === 'M')).toEqual({ type: 'M', x: 10, y: 11 });
+  });
+
+  test('keeps entity ids stable across snapshots with NUMERIC_IDS', async () => {
+    const { CAPS } = TcpServer;
+    client.send(connectPacket(9, CAPS.WIDE_COORDS | CAPS.NUMERIC_IDS | CAPS.FRAMED, 'Alice'));
+    expect(parseConnect(await client.next()).caps).toBe(CAPS.WIDE_COORDS | CAPS.NUMERIC_IDS | CAPS.FRAMED);
+    client.framed = true;
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 5, 5);
+    world.mobs.clear();
+    world.addPlayer(new Player('p2', 'Bob', 30, 15));
+    world.addPlayer(new Player('p3', 'Carol', 39, 19));
+    world.tick = () => {};
+    const poll = async () => {
+      client.send([0x03]);
+      const framed = await client.next();
+      return parseState(Buffer.concat([framed.subarray(0, 1), framed.subarray(3)]), 2, true);
+    };
+    const idAt = (state, x) => state.find(e => e.x === x).id;
+
+    const first = await poll();
+    expect(new Set(first.map(e => e.id)).size).toBe(3);
+    expect(first.every(e => e.id > 0)).toBe(true);
+
+    // Bob leaves and Dave arrives: the others keep their ids and Dave gets a fresh one
+    world.removePlayer('p2');
+    world.addPlayer(new Player('p4', 'Dave', 20, 10));
+    world.moveEntity(me, 6, 5);
+    const second = await poll();
+    expect(idAt(second, 6)).toBe(idAt(first, 5));
+    expect(idAt(second, 39)).toBe(idAt(first, 39));
+    expect(first.map(e => e.id)).not.toContain(idAt(second, 20));
+  });
+
+  test('carries entity ids in packed literals and runs', async () => {
+    const { CAPS } = TcpServer;
+    const caps = CAPS.WIDE_COORDS | CAPS.PACKED | CAPS.DELTA | CAPS.NUMERIC_IDS;
+    client.send(connectPacket(9, caps, 'Alice'));
+    const reply = parseConnect(await client.next());
+    expect(reply.caps).toBe(caps);
+    client.coord = 2;
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 5, 5);
+    world.mobs.clear();
+    world.addPlayer(new Player('p2', 'Bob', 30, 15));
+    world.tick = () => {};
+
+    client.send([0x03]);
+    const full = parsePacked(await client.next(), parsePacked(reply.state, [], true).entities, true);
+    client.send([0x02, 'r'.charCodeAt(0)]);
+    await client.next();
+    client.send([0x03]);
+    const second = parsePacked(await client.next(), full.entities, true);
+    expect(second.runs).toBeGreaterThan(0);
+    const byType = (state) => Object.fromEntries(state.entities.map(e => [e.type, e.id]));
+    expect(byType(second)).toEqual(byType(full));
+    expect(second.entities.find(e => e.type === 'M').x).toBe(6);
+  });
+
+  test('answers pings and records the reported round-trip time', async () => {
+    await client.join('Alice');
+    world.ticks = 1234;
+    const before = Date.now();
+    client.send([0x0A, 0x34, 0x12, 85, 0]);
+    const pong = await client.next();
+
+    expect(pong.readUInt16LE(1)).toBe(0x1234);
+    expect(pong.readUInt16LE(3)).toBe(1234);
+    expect(pong[5]).toBe(0);
+    expect(pong.readUInt32LE(6)).toBeGreaterThanOrEqual(before % 0x100000000);
+
+    const stats = tcp.getStats();
+    expect(stats.connections.map(c => [c.player, c.rttMs])).toEqual([['Alice', 85]]);
+    expect(stats.meanRttMs).toBe(85);
+  });
+
+  test('acknowledges sequenced moves, including ones that were not applied', async () => {
+    await client.join('Alice');
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 5, 0);
+
+    client.send([0x0B, 41, 'd'.charCodeAt(0), 0x0B, 42, 'u'.charCodeAt(0), 0x0B, 43, 'u'.charCodeAt(0)]);
+    const replies = [await client.next(), await client.next(), await client.next()];
+    expect(replies.map(r => [r[0], r[1], r[2], r[3]])).toEqual([
+      [0x0B, 41, 5, 1],
+      [0x0B, 42, 5, 0],
+      [0x0B, 43, 5, 0] // Blocked at the edge: still answered
+    ]);
+    expect(replies[2][5]).toBe(0); // No collision
+  });
+
+  test('acknowledges sequenced moves from a socket without a player', async () => {
+    client.send([0x0B, 7, 'd'.charCodeAt(0), 0x0C, 9, 3, ...Buffer.from('ddd'), 0x02, 'd'.charCodeAt(0), 0x0A, 0, 0, 0, 0]);
+    const replies = [await client.next(), await client.next()];
+    expect(replies.map(r => [r[0], r[1], r[4]])).toEqual([
+      [0x0B, 7, 0],
+      [0x0B, 11, 0] // One ack with the batch's last seq
+    ]);
+    expect((await client.next())[0]).toBe(0x0A); // The plain move is not answered
+  });
+
+  test('applies batched moves in order and answers them with one reply', async () => {
+    await client.join('Alice');
+    const me = tcp.clients.values().next().value.player;
+    world.moveEntity(me, 5, 0);
+
+    // Moves 254, 255, 0, 1, 2: the last one is blocked at the edge
+    client.send([0x0C, 254, 5, ...Buffer.from('dduuu'), 0x0A, 0, 0, 0, 0]);
+    const ack = await client.next();
+    expect([ack[0], ack[1], ack[2], ack[3]]).toEqual([0x0B, 2, 5, 0]);
+    expect(ack[5]).toBe(0); // No collision
+    expect((await client.next())[0]).toBe(0x0A); // Nothing else answered the batch
+    expect([me.x, me.y]).toEqual([5, 0]);
+  });
+
+  describe('resume', () => {
+    const { CAPS } = TcpServer;
+    const caps = CAPS.WIDE_COORDS | CAPS.PACKED | CAPS.DELTA | CAPS.RESUME;
+
+    async function dropAfterPoll() {
+      client.send(connectPacket(9, caps, 'Alice'));
+      const reply = parseConnect(await client.next());
+      client.coord = 2;
+      const me = world.getPlayer(reply.id);
+      world.moveEntity(me, 7, 9);
+      client.send([0x03]);
+      const last = parsePacked(await client.next(), parsePacked(reply.state).entities);
+
+      client.close();
+      while (tcp.sessions.size === 0) {
+        await new Promise((resolve) => setTimeout(resolve, 5));
+      }
+      client = new TestClient(port);
+      client.coord = 2;
+      await new Promise((resolve) => client.socket.once('connect', resolve));
+      return { reply, last };
+    }
+
+    test('restores the player, its position and the run base', async () => {
+      const { reply, last } = await dropAfterPoll();
+      expect(world.getPlayer(reply.id)).toBeNull();
+
+      client.send(resumePacket(caps, last.ticks, last.entities.length, reply.token));
+      const resumed = parseConnect(await client.next());
+      expect(resumed.id).toBe(reply.id);
+      expect([resumed.x, resumed.y]).toEqual([7, 9]);
+      expect(resumed.token.equals(reply.token)).toBe(false);
+      expect(world.getPlayer(reply.id)).not.toBeNull();
+      expect(parsePacked(resumed.state, last.entities).runs).toBeGreaterThan(0);
+    });
+
+    test('sends a keyframe when the client missed the last snapshot', async () => {
+      const { reply, last } = await dropAfterPoll();
+      client.send(resumePacket(caps, last.ticks - 1, last.entities.length, reply.token));
+      const resumed = parseConnect(await client.next());
+      expect(resumed.id).toBe(reply.id);
+      expect(parsePacked(resumed.state).runs).toBe(0);
+    });
+
+    test('refuses unknown and expired tokens', async () => {
+      const { reply, last } = await dropAfterPoll();
+      client.send(resumePacket(caps, last.ticks, 1, Buffer.alloc(8)));
+      expect([...await client.next()]).toEqual([0x09, 0, 0]);
+
+      clearTimeout(tcp.sessions.values().next().value.timer);
+      tcp.sessions.clear(); // As if the grace window ran out
+      client.send(resumePacket(caps, last.ticks, 1, reply.token));
+      expect([...await client.next()]).toEqual([0x09, 0, 0]);
+    });
+  });
+
+  test('never uses runs in state encoded for unreliable transports', async () => {
+    client.send([0x05, 3]);
+    await client.next();
+    await client.join('Alice');
+    const socket = tcp.clients.values().next().value;
+    const state = world.getSnapshot(null);
+
+    tcp.encodeState(socket, state);
+    const packet = tcp.encodeState(socket, state, { delta: false });
+    expect(parsePacked(packet).runs).toBe(0);
+    // The TCP base is left alone, so the next TCP packet can still use runs
+    expect(parsePacked(tcp.encodeState(socket, state)).runs).toBe(1);
+  });
+});
+
+describe('TcpServer with arenas', () => {
+  let arenas;
+  let tcp;
+  let clients;
+
+  beforeEach((done) => {
+    arenas = new ArenaManager({ workers: 1, maxPlayers: 1, minMobs: 0 });
+    arenas.start();
+    tcp = new TcpServer(null, 0, { arenas });
+    tcp.server.once('listening', done);
+    tcp.start();
+    clients = [];
+  });
+
+  afterEach((done) => {
+    clients.forEach(c => c.close());
+    tcp.stop(() => arenas.stop().then(() => done()));
+  });
+
+  function connect() {
+    const client = new TestClient(tcp.server.address().port);
+    clients.push(client);
+    return client;
+  }
+
+  test('places each join into an arena and keeps replies in order', async () => {
+    const alice = connect();
+    const bob = connect();
+    alice.send([0x01, 5, ...Buffer.from('Alice'), 0x03]);
+    bob.send([0x01, 3, ...Buffer.from('Bob'), 0x03]);
+
+    expect((await alice.next())[0]).toBe(0x01);
+    expect(parseState(await alice.next()).map(e => e.type)).toEqual(['M']);
+    expect((await bob.next())[0]).toBe(0x01);
+    expect(parseState(await bob.next()).length).toBe(1);
+
+    expect(arenas.getStats().arenas.length).toBe(2);
+  });
+
+  test('answers a connect from the arena', async () => {
+    const alice = connect();
+    alice.send(connectPacket(5, TcpServer.SERVER_CAPS, 'Alice'));
+    const reply = parseConnect(await alice.next());
+    expect(reply.width).toBe(arenas.width);
+    expect(parsePacked(reply.state).entities.map(e => e.type)).toEqual(['M']);
+  });
+
+  test('leaves the arena when the socket closes before the join is answered', async () => {
+    const alice = connect();
+    await new Promise((resolve) => alice.socket.once('connect', resolve));
+    alice.send([0x01, 5, ...Buffer.from('Alice')]);
+    alice.close();
+
+    // The join still lands in an arena; the queued leave must then empty it
+    for (let i = 0; i < 100 && tcp.clients.size > 0; i++) {
+      await new Promise((resolve) => setTimeout(resolve, 10));
+    }
+    for (let i = 0; i < 100 && arenas.getStats().arenas.some(a => a.players > 0); i++) {
+      await new Promise((resolve) => setTimeout(resolve, 10));
+    }
+    expect(tcp.clients.size).toBe(0);
+    expect(arenas.getStats().arenas.filter(a => a.players > 0)).toEqual([]);
+  });
+
+  test('applies batched moves through the arena', async () => {
+    const alice = connect();
+    const start = await alice.join('Alice');
+    const x = start[2 + start[1]];
+    const dir = x > 0 ? 'l' : 'r';
+
+    alice.send([0x0C, 7, 2, ...Buffer.from(dir + dir)]);
+    const ack = await alice.next();
+    expect([ack[0], ack[1]]).toEqual([0x0B, 8]);
+    expect(Math.abs(ack[2] - x)).toBeLessThanOrEqual(2);
+  });
+});
@@ -0,0 +1,118 @@
+/**
+ * UDP Snapshot Server Tests
+ */
+
+const dgram = require('dgram');
+const net = require('net');
+const World = require('../src/world');
+const TcpServer = require('../src/tcp_server');
+const UdpServer = require('../src/udp_server');
+
+describe('UdpServer', () => {
+  let world;
+  let tcp;
+  let udp;
+  let tcpClient;
+  let udpClient;
+
+  beforeEach((done) => {
+    world = new World(40, 20);
+    tcp = new TcpServer(world, 0);
+    udp = new UdpServer(world, 0, tcp, { tickMs: 20 });
+    udpClient = dgram.createSocket('udp4');
+    udp.socket.once('listening', () => {
+      tcpClient = net.connect(tcp.server.address().port, '127.0.0.1');
+      tcpClient.once('connect', () => done());
+    });
+    tcp.server.once('listening', () => udp.start());
+    tcp.start();
+  });
+
+  afterEach((done) => {
+    tcpClient.destroy();
+    udpClient.close();
+    udp.stop(() => tcp.stop(() => done()));
+  });
+
+  // Join over TCP and return the player id from the 0x01 reply
+  function join(name) {
+    return new Promise((resolve) => {
+      tcpClient.once('data', (data) => resolve(data.subarray(2, 2 + data[1]).toString()));
+      tcpClient.write(Buffer.from([0x01, name.length, ...Buffer.from(name)]));
+    });
+  }
+
+  function subscribe(playerId) {
+    const id = Buffer.from(playerId);
+    udpClient.send(Buffer.from([0x10, id.length, ...id]), udp.socket.address().port, '127.0.0.1');
+  }
+
+  function nextDatagram() {
+    return new Promise((resolve) => udpClient.once('message', resolve));
+  }
+
+  // Connect asking only for UDP; reply: 0x08 [Len] [Ver] [Caps] [W] [H] [IdLen] [Id] [X] [Y] [Hp] [VerLen] [Ver] ...
+  function connectForUdp(name) {
+    return new Promise((resolve) => {
+      tcpClient.once('data', (data) => {
+        const caps = data.readUInt16LE(4);
+        const verAt = 11 + data[10] + 3;
+        const portAt = verAt + 1 + data[verAt];
+        resolve({ caps, port: caps & 0x80 ? data.readUInt16LE(portAt) : 0 });
+      });
+      tcpClient.write(Buffer.from([0x08, 8, 0x80, 0, 40, 20, name.length, ...Buffer.from(name)]));
+    });
+  }
+
+  test('offers the UDP port in connect replies while listening', async () => {
+    const reply = await connectForUdp('Alice');
+    expect(reply.caps).toBe(0x80);
+    expect(reply.port).toBe(udp.socket.address().port);
+  });
+
+  test('does not offer UDP once the channel has stopped', async () => {
+    await new Promise((resolve) => udp.stop(resolve));
+    udp.stop = (callback) => callback(); // Already closed for afterEach
+    const reply = await connectForUdp('Alice');
+    expect(reply.caps).toBe(0);
+  });
+
+  test('pushes sequence-numbered snapshots to a subscribed player', async () => {
+    const playerId = await join('Alice');
+    subscribe(playerId);
+
+    const first = await nextDatagram();
+    const second = await nextDatagram();
+    expect(first[0]).toBe(0x11);
+    expect(second.readUInt16LE(1)).toBe((first.readUInt16LE(1) + 1) & 0xFFFF);
+
+    // Payload is the TCP state packet; the only entity is us
+    expect(first[3]).toBe(0x03);
+    expect(first[4]).toBe(1);
+    expect(String.fromCharCode(first[3 + 5 + first[3 + 4]])).toBe('M');
+  });
+
+  test('ticks the world while anyone is subscribed', async () => {
+    const playerId = await join('Alice');
+    subscribe(playerId);
+    await nextDatagram();
+    expect(world.ticks).toBeGreaterThan(0);
+  });
+
+  test('ignores subscriptions for unknown players', async () => {
+    subscribe('player_nobody');
+    await new Promise((resolve) => setTimeout(resolve, 60));
+    expect(udp.subscriptions.size).toBe(0);
+    expect(world.ticks).toBe(0);
+  });
+
+  test('drops the subscription when the TCP session ends', async () => {
+    const playerId = await join('Alice');
+    subscribe(playerId);
+    await nextDatagram();
+
+    tcpClient.destroy();
+    await new Promise((resolve) => setTimeout(resolve, 60));
+    expect(udp.subscriptions.size).toBe(0);
+  });
+});
@@ -4,6 +4,7 @@
 
 const World = require('../src/world');
 const Player = require('../src/player');
+const Mob = require('../src/mob');
 
 describe('World', () => {
   let world;
@@ -162,6 +163,82 @@ describe('World', () => {
     });
   });
 
+  describe('area of interest', () => {
+    let big;
+
+    beforeEach(() => {
+      big = new World(100, 60);
+    });
+
+    test('centres the viewport on the viewer and clamps it to the world', () => {
+      expect(big.getViewportRect(50, 30, 40, 20, 0)).toEqual({ x0: 30, y0: 20, x1: 69, y1: 39 });
+      expect(big.getViewportRect(2, 2, 40, 20, 0)).toEqual({ x0: 0, y0: 0, x1: 39, y1: 19 });
+      expect(big.getViewportRect(99, 59, 40, 20, 0)).toEqual({ x0: 60, y0: 40, x1: 99, y1: 59 });
+    });
+
+    test('covers the whole 40x20 world for a 40x20 viewport', () => {
+      expect(world.getViewportRect(5, 5, 40, 20)).toEqual({ x0: 0, y0: 0, x1: 39, y1: 19 });
+    });
+
+    test('returns only nearby entities, players first', () => {
+      big.addMob(new Mob('m1', 'Goblin1', 52, 31));
+      big.addPlayer(new Player('p1', 'Alice', 50, 30));
+      big.addPlayer(new Player('p2', 'Bob', 5, 5));
+
+      const ids = big.getEntitiesInRect(big.getViewportRect(50, 30, 40, 20)).map(e => e.id);
+      expect(ids).toEqual(['p1', 'm1']);
+    });
+
+    test('tracks entities moved through moveEntity', () => {
+      const p1 = new Player('p1', 'Alice', 5, 5);
+      big.addPlayer(p1);
+      big.moveEntity(p1, 80, 50);
+
+      expect(big.getEntitiesInRect({ x0: 0, y0: 0, x1: 20, y1: 20 }).length).toBe(0);
+      expect(big.getEntitiesInRect({ x0: 70, y0: 40, x1: 90, y1: 59 })).toEqual([p1]);
+    });
+
+    test('limits getState entities to the requested area', () => {
+      big.addPlayer(new Player('p1', 'Alice', 50, 30));
+      big.addPlayer(new Player('p2', 'Bob', 5, 5));
+
+      const state = big.getState({ x0: 40, y0: 20, x1: 60, y1: 40 });
+      expect(state.players.length).toBe(1);
+      expect(state.players[0].id).toBe('p1');
+    });
+  });
+
+  describe('large worlds', () => {
+    test('clamps dimensions to 16 bits', () => {
+      const huge = new World(100000, 70000);
+      expect(huge.width).toBe(65535);
+      expect(huge.height).toBe(65535);
+    });
+
+    test('allocates chunks only where entities are', () => {
+      const huge = new World(20000, 20000);
+      huge.addPlayer(new Player('p1', 'Alice', 10, 10));
+      huge.addPlayer(new Player('p2', 'Bob', 12, 11));
+      huge.addPlayer(new Player('p3', 'Carol', 19000, 19000));
+
+      expect(huge.grid.cellCount).toBe(2);
+      expect(huge.getPlayerAtPosition(19000, 19000).id).toBe('p3');
+
+      huge.removePlayer('p3');
+      expect(huge.grid.cellCount).toBe(1);
+    });
+
+    test('finds mobs by position after they move', () => {
+      const huge = new World(5000, 5000);
+      const mob = new Mob('m1', 'Goblin1', 4000, 4000);
+      huge.addMob(mob);
+      huge.moveEntity(mob, 4001, 4000);
+
+      expect(huge.getMobAtPosition(4000, 4000)).toBeNull();
+      expect(huge.getMobAtPosition(4001, 4000)).toBe(mob);
+    });
+  });
+
   describe('reset', () => {
     test('clears all players', () => {
       const p1 = new Player('p1', 'Alice', 10, 10);
@@ -0,0 +1,153 @@
+/**
+ * Zone Manager Tests
+ */
+
+const ZoneManager = require('../src/zone_manager');
+const Player = require('../src/player');
+const Mob = require('../src/mob');
+
+describe('ZoneManager', () => {
+  let zones;
+
+  beforeEach(() => {
+    zones = new ZoneManager(100, 50, 2, 1);
+  });
+
+  afterEach(() => {
+    zones.stop();
+  });
+
+  test('splits the world into zone rectangles', () => {
+    expect(zones.zones.length).toBe(2);
+    expect(zones.zones[0].bounds).toEqual({ x0: 0, y0: 0, x1: 49, y1: 49 });
+    expect(zones.zones[1].bounds).toEqual({ x0: 50, y0: 0, x1: 99, y1: 49 });
+    expect(zones.zoneAt(49, 10)).toBe(zones.zones[0]);
+    expect(zones.zoneAt(50, 10)).toBe(zones.zones[1]);
+  });
+
+  test('places entities in the zone owning their position', () => {
+    zones.addPlayer(new Player('p1', 'Alice', 10, 10));
+    zones.addPlayer(new Player('p2', 'Bob', 80, 10));
+
+    expect(zones.zoneOf('p1')).toBe(zones.zones[0]);
+    expect(zones.zoneOf('p2')).toBe(zones.zones[1]);
+    expect(zones.getPlayerCount()).toBe(2);
+    expect(zones.getPlayerAtPosition(80, 10).name).toBe('Bob');
+  });
+
+  test('hands a player off when it crosses a zone edge', () => {
+    const player = new Player('p1', 'Alice', 49, 10);
+    zones.addPlayer(player);
+
+    zones.moveEntity(player, 50, 10);
+
+    expect(zones.zoneOf('p1')).toBe(zones.zones[1]);
+    expect(zones.zones[0].getPlayer('p1')).toBeNull();
+    expect(zones.zones[1].getPlayer('p1')).toBe(player);
+    expect(zones.getPlayerAtPosition(50, 10)).toBe(player);
+    expect(zones.handoffs).toBe(1);
+  });
+
+  test('hands off mobs that wander across an edge during a zone tick', () => {
+    const mob = new Mob('m1', 'Goblin1', 49, 10);
+    zones.addMob(mob);
+    mob.moveRandom = function () { this.setPosition(51, 10); };
+
+    zones.stepZone(zones.zones[0]);
+
+    expect(zones.zoneOf('m1')).toBe(zones.zones[1]);
+    expect(zones.getMobAtPosition(51, 10)).toBe(mob);
+  });
+
+  test('forgets mobs a zone removes during its own tick', () => {
+    zones.addMob(new Mob('m1', 'Goblin1', 10, 10));
+    zones.zones[0].removeMob('m1'); // As a lost fight does inside World.tick
+
+    zones.stepZone(zones.zones[0]);
+
+    expect(zones.zoneOf('m1')).toBeNull();
+    expect(zones.entityZones.size).toBe(0);
+  });
+
+  test('lets hunters target players across a zone edge', () => {
+    const hunter = new Mob('h1', 'Hunter', 47, 10, true);
+    zones.addMob(hunter);
+    zones.addPlayer(new Player('p1', 'Alice', 52, 10));
+
+    zones.stepZone(zones.zones[0]);
+
+    expect(hunter.lastTargetId).toBe('p1');
+  });
+
+  test('settles a fight across a zone edge in both zones', () => {
+    zones.addMob(new Mob('h1', 'Hunter', 49, 10, true));
+    zones.addPlayer(new Player('p1', 'Alice', 50, 10));
+
+    zones.stepZone(zones.zones[0]);
+
+    if (zones.getPlayer('p1')) {
+      expect(zones.getMob('h1')).toBeNull();
+      expect(zones.entityZones.has('h1')).toBe(false);
+    } else {
+      expect(zones.getDisconnectedPlayer('Alice').id).toBe('p1');
+      expect(zones.entityZones.has('p1')).toBe(false);
+    }
+  });
+
+  test('collects a player killed from the neighbouring zone straight away', () => {
+    zones.addMob(new Mob('h1', 'Hunter', 49, 10, true));
+    zones.addPlayer(new Player('p1', 'Alice', 50, 10));
+    const random = Math.random;
+    Math.random = () => 0; // The hunter wins every round
+
+    try {
+      zones.stepZone(zones.zones[0]);
+    } finally {
+      Math.random = random;
+    }
+
+    expect(zones.zones[1].getPlayer('p1')).toBeNull();
+    expect(zones.zones[1].disconnectedPlayers.size).toBe(0);
+    expect(zones.getDisconnectedPlayer('Alice').id).toBe('p1');
+    expect(zones.entityZones.has('p1')).toBe(false);
+  });
+
+  test('shows border entities from the neighbouring zone', () => {
+    zones.addPlayer(new Player('p1', 'Alice', 47, 10));
+    zones.addMob(new Mob('m1', 'Goblin1', 51, 10));
+    zones.addMob(new Mob('m2', 'Goblin2', 95, 40));
+
+    const area = zones.getViewportRect(47, 10, 10, 10, 0);
+    const state = zones.getState(area);
+
+    expect(state.players.map(e => e.id)).toEqual(['p1', 'm1']);
+    expect(state.zones).toBe(2);
+  });
+
+  test('keeps disconnected players for rejoin', () => {
+    zones.addPlayer(new Player('p1', 'Alice', 80, 10));
+    expect(zones.removePlayer('p1')).toBe(true);
+
+    expect(zones.getPlayer('p1')).toBeNull();
+    expect(zones.getDisconnectedPlayer('Alice').id).toBe('p1');
+    expect(zones.isRejoiningPlayer('Alice')).toBe(true);
+  });
+
+  test('spawns mobs in every zone', () => {
+    const spawned = zones.respawnMobs(4);
+    expect(spawned.length).toBe(4);
+    for (const zone of zones.zones) {
+      expect(zone.getAllMobs().length).toBe(2);
+      for (const mob of zone.getAllMobs()) {
+        expect(zone.ownsPosition(mob.x, mob.y)).toBe(true);
+      }
+    }
+  });
+
+  test('does not advance zones when taking a snapshot', () => {
+    zones.getState();
+    expect(zones.ticks).toBe(0);
+    zones.step();
+    expect(zones.getState().ticks).toBe(1);
+  });
+});